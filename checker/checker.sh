@@ -112,6 +112,110 @@ function is_speedup_test {
     return 0
 }
 
+# se ruleaza o varianta cu optiuni suplimentare si se compara cu rularea
+# implicita din test_def: fisierele literelor si indexul binar trebuie sa fie
+# identice (parametri: optiuni, lista de intrare optionala, implicit test.txt)
+function check_mode {
+    label="${1:-optiunile implicite}${2:+ pe $2}"
+    echo "Se verifica varianta cu $label..."
+    mkdir -p test_mode
+
+    timeout 200 ./tema1 4 4 ${2:-./test.txt} --output=both --index-file=test_mode/index.bin $1 > test_mode/out.txt 2>&1
+    if [ $? != 0 ]
+    then
+        echo "W: Rularea cu $label nu s-a putut executa cu succes"
+        cat test_mode/out.txt
+        mode_failures=$((mode_failures+1))
+        rm -rf test_mode
+        return
+    fi
+    for x in {a..z}
+    do
+        mv $x.txt test_mode 2>/dev/null
+    done
+
+    compare_outputs test_mode test_def
+    if [ $? != 0 ] || ! cmp -s test_mode/index.bin test_def/index.bin
+    then
+        echo "W: Rularea cu $label difera de rularea implicita"
+        mode_failures=$((mode_failures+1))
+    else
+        echo "OK"
+    fi
+    echo ""
+
+    rm -rf test_mode
+}
+
+# un pas al indexarii incrementale: se ruleaza cu --incremental=test_inc/index
+# pe lista data si se compara cu o rulare completa pe aceeasi lista
+# (parametri: lista, descriere)
+function check_incremental {
+    echo "Se verifica indexarea incrementala ($2)..."
+    mkdir -p test_full test_mode
+
+    timeout 200 ./tema1 4 4 $1 > test_full/out.txt 2>&1 &&
+        for x in {a..z}; do mv $x.txt test_full 2>/dev/null; done &&
+        timeout 200 ./tema1 4 4 $1 --incremental=test_inc/index > test_mode/out.txt 2>&1
+    if [ $? != 0 ]
+    then
+        echo "W: Rularea incrementala ($2) nu s-a putut executa cu succes"
+        cat test_full/out.txt test_mode/out.txt 2>/dev/null
+        mode_failures=$((mode_failures+1))
+        rm -rf test_full test_mode
+        return
+    fi
+    for x in {a..z}
+    do
+        mv $x.txt test_mode 2>/dev/null
+    done
+
+    compare_outputs test_mode test_full
+    if [ $? != 0 ]
+    then
+        echo "W: Rularea incrementala ($2) difera de rularea completa"
+        mode_failures=$((mode_failures+1))
+    else
+        echo "OK"
+    fi
+    echo ""
+
+    rm -rf test_full test_mode
+}
+
+# interogarile din test_query/queries.txt (AND/OR/NOT, fraze, ~k, RANK) pe
+# un index construit cu --positions trebuie sa dea raspunsurile din
+# test_query/expected.txt
+function check_queries {
+    echo "Se verifica interogarile pe indexul cu pozitii..."
+    mkdir -p test_mode
+
+    timeout 200 ./tema1 4 4 ./test.txt --output=binary --positions --index-file=test_mode/index.bin > test_mode/out.txt 2>&1 &&
+        timeout 200 ./tema1 query test_mode/index.bin < test_query/queries.txt > test_mode/answers.txt 2>&1
+    if [ $? != 0 ]
+    then
+        echo "W: Interogarile nu s-au putut executa cu succes"
+        cat test_mode/out.txt test_mode/answers.txt
+        mode_failures=$((mode_failures+1))
+    elif ! diff -q test_mode/answers.txt test_query/expected.txt > /dev/null
+    then
+        echo "W: Raspunsurile interogarilor difera de test_query/expected.txt"
+        mode_failures=$((mode_failures+1))
+    else
+        echo "OK"
+    fi
+    echo ""
+
+    rm -rf test_mode
+}
+
+# scrie in $1 lista fisierelor primite pe stdin, in formatul lui test.txt
+function write_list {
+    sed '/^$/d' > $1.tmp
+    (wc -l < $1.tmp; cat $1.tmp) > $1
+    rm -f $1.tmp
+}
+
 #echo "VMCHECKER_TRACE_CLEANUP"
 date
 
@@ -246,6 +350,72 @@ do
     done
 done
 
+# modurile alternative (shuffle, spill pe disc) trebuie sa dea exact rezultatul
+# implicit; nu se puncteaza separat
+mode_failures=0
+mkdir -p test_def
+timeout 200 ./tema1 4 4 ./test.txt --output=both --index-file=test_def/index.bin > test_def/out.txt 2>&1
+for x in {a..z}
+do
+    mv $x.txt test_def 2>/dev/null
+done
+
+# bugetul minim de memorie forteaza varsarea pe disc, interclasarea externa
+# si reducerii care citesc run-urile varsate
+check_mode "--memory-budget=1"
+
+# shuffle-ul in flux (reducerii pornesc odata cu mapperii) si cel cu procese
+# separate, prin memfd
+check_mode "--shuffle=stream"
+check_mode "--shuffle=process"
+
+check_queries
+
+# intrari comprimate: o treime din fisiere sunt inlocuite cu copii gzip
+# (.gz), care trebuie sa dea exact rezultatul fisierelor necomprimate
+rm -rf test_gz
+awk 'NR > 1 && NR % 3 == 0' test.txt | while read f
+do
+    mkdir -p test_gz/$(dirname $f)
+    gzip -c $f > test_gz/$f.gz
+done
+tail -n +2 test.txt | awk 'NR % 3 == 2 { print "test_gz/" $0 ".gz"; next } { print }' | write_list test_gz/test.txt
+check_mode "" test_gz/test.txt
+check_mode "--prefetch=8 --shuffle=process" test_gz/test.txt
+check_mode "--memory-budget=1" test_gz/test.txt
+rm -rf test_gz
+
+# indexarea incrementala, pe o copie a intrarilor (fisierele se modifica):
+# jumatate din fisiere, apoi toate, apoi cu fisiere sterse, modificate sau
+# doar atinse (mtime nou, acelasi continut), apoi cu cele sterse readaugate
+rm -rf test_inc
+mkdir -p test_inc
+cp -r test_in test_inc/in
+tail -n +2 test.txt | sed 's|^test_in/|test_inc/in/|' > test_inc/files.txt
+half=$(( $(wc -l < test_inc/files.txt) / 2 ))
+
+head -n $half test_inc/files.txt | write_list test_inc/list.txt
+check_incremental test_inc/list.txt "jumatate din fisiere"
+
+write_list test_inc/list.txt < test_inc/files.txt
+check_incremental test_inc/list.txt "toate fisierele"
+
+echo "incremental zzzcheck" >> $(sed -n 3p test_inc/files.txt)
+echo "incremental zzzcheck" >> $(sed -n $((half + 5))p test_inc/files.txt)
+touch $(sed -n 10p test_inc/files.txt) $(sed -n $((half + 10))p test_inc/files.txt)
+awk 'NR % 7 != 0' test_inc/files.txt | write_list test_inc/list.txt
+check_incremental test_inc/list.txt "fisiere sterse, modificate si atinse"
+
+write_list test_inc/list.txt < test_inc/files.txt
+check_incremental test_inc/list.txt "fisiere readaugate"
+rm -rf test_inc
+
+rm -rf test_def
+if [ $mode_failures != 0 ]
+then
+    echo "W: $mode_failures variante difera de rularea implicita"
+fi
+
 echo "=========================="
 echo ""
 
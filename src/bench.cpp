@@ -0,0 +1,246 @@
+// Microbenchmark-uri pentru caile critice ale indexatorului.
+// ./bench [--repeats=N] [--threads=N] [--filter=text]
+// Fiecare benchmark ruleaza o data de incalzire si apoi de N ori; se
+// afiseaza debitul mediu, abaterea standard (in procente) si cel mai bun
+// debit. Datele sunt sintetice, generate cu o samanta fixa, deci rularile
+// sunt comparabile intre ele.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "tokenizer.h"
+#include "term_dictionary.h"
+#include "postings.h"
+#include "reducer_data.h"
+#include "output_writer.h"
+
+struct BenchArgs {
+    int repeats = 7;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::string filter; // ruleaza doar benchmark-urile care contin textul
+};
+
+BenchArgs parseBenchArgs(int argc, char** argv) {
+    BenchArgs args;
+    for(int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        size_t eq = option.find('=');
+        std::string name = option.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
+        if(name == "--repeats") {
+            args.repeats = std::stoi(value);
+        } else if(name == "--threads") {
+            args.threads = std::stoi(value);
+        } else if(name == "--filter") {
+            args.filter = value;
+        } else {
+            throw std::invalid_argument("Optiune necunoscuta: " + option);
+        }
+    }
+    if(args.repeats <= 0 || args.threads <= 0) {
+        throw std::invalid_argument("--repeats si --threads trebuie sa fie pozitive");
+    }
+    return args;
+}
+
+// Ruleaza un benchmark si afiseaza debitul; body() intoarce cate unitati
+// (octeti, cuvinte, operatii) a procesat. setup(), daca exista, pregateste
+// datele inaintea fiecarei rulari si nu intra in timp.
+void runBench(const BenchArgs& args, const std::string& name, const char* unit,
+              const std::function<double()>& body,
+              const std::function<void()>& setup = nullptr) {
+    if(!args.filter.empty() && name.find(args.filter) == std::string::npos) {
+        return;
+    }
+    if(setup) setup();
+    body(); // incalzire
+    std::vector<double> rates;
+    for(int r = 0; r < args.repeats; r++) {
+        if(setup) setup();
+        auto start = std::chrono::steady_clock::now();
+        double units = body();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rates.push_back(units / seconds);
+    }
+    double mean = 0;
+    for(double rate : rates) mean += rate;
+    mean /= rates.size();
+    double variance = 0;
+    for(double rate : rates) variance += (rate - mean) * (rate - mean);
+    double stddev = std::sqrt(variance / rates.size());
+    std::printf("%-36s %10.2f %-8s +-%5.1f%%   max %10.2f\n", name.c_str(), mean, unit,
+                100.0 * stddev / mean, *std::max_element(rates.begin(), rates.end()));
+    std::fflush(stdout);
+}
+
+// Vocabular sintetic: cuvinte de 2..12 litere, cu frecvente Zipf
+struct Corpus {
+    std::vector<std::string> vocabulary;
+    std::vector<uint32_t> stream; // indici in vocabular, in ordinea "textului"
+    std::string text; // acelasi flux, cu majuscule, punctuatie si spatii
+
+    Corpus(size_t vocabulary_size, size_t tokens) {
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<int> length(2, 12), letter(0, 25);
+        for(size_t i = 0; i < vocabulary_size; i++) {
+            std::string word;
+            int n = length(rng);
+            for(int j = 0; j < n; j++) word += static_cast<char>('a' + letter(rng));
+            vocabulary.push_back(word);
+        }
+        // Zipf(1) prin inversarea functiei de repartitie cumulate
+        std::vector<double> cdf(vocabulary_size);
+        double sum = 0;
+        for(size_t i = 0; i < vocabulary_size; i++) {
+            sum += 1.0 / (i + 1);
+            cdf[i] = sum;
+        }
+        std::uniform_real_distribution<double> uniform(0, sum);
+        std::uniform_int_distribution<int> noise(0, 15);
+        for(size_t t = 0; t < tokens; t++) {
+            uint32_t w = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+            stream.push_back(std::min<uint32_t>(w, vocabulary_size - 1));
+            std::string word = vocabulary[stream.back()];
+            int kind = noise(rng);
+            if(kind == 0) word[0] = static_cast<char>(word[0] - 32); // majuscula
+            if(kind == 1) word += ',';
+            if(kind == 2) word = "\"" + word;
+            text += word;
+            text += kind == 3 ? '\n' : ' ';
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    try {
+        BenchArgs args = parseBenchArgs(argc, argv);
+        Corpus corpus(50000, 2000000);
+        std::printf("corpus: %zu cuvinte, %.1f MB, vocabular %zu; repetari %d, threaduri %d\n\n",
+                    corpus.stream.size(), corpus.text.size() / 1e6, corpus.vocabulary.size(),
+                    args.repeats, args.threads);
+
+        // --- normalizeWord ---
+        std::vector<std::string> raw;
+        for(size_t i = 0; i < 200000; i++) {
+            raw.push_back(corpus.vocabulary[corpus.stream[i]] + "'S,");
+            raw.back()[0] = static_cast<char>(raw.back()[0] - 32);
+        }
+        runBench(args, "normalizeWord", "Mcuv/s", [&]() {
+            std::string normalized;
+            size_t total = 0;
+            for(const auto& word : raw) {
+                normalizeWord(word, normalized);
+                total += normalized.size();
+            }
+            if(total == 0) std::abort();
+            return raw.size() / 1e6;
+        });
+
+        // --- tokenizare + normalizare, pe fiecare nivel SIMD disponibil;
+        // /utf8 masoara costul modului --normalize=utf8 pe acelasi text ASCII ---
+        std::vector<std::pair<SimdLevel, const char*>> levels = {{SimdLevel::Scalar, "scalar"}};
+        if(detectSimdLevel() >= SimdLevel::SSE2) levels.push_back({SimdLevel::SSE2, "sse2"});
+        if(detectSimdLevel() >= SimdLevel::AVX2) levels.push_back({SimdLevel::AVX2, "avx2"});
+        for(const auto& [level, level_name] : levels) {
+            SimdLevel simd = level;
+            runBench(args, std::string("tokenize/") + level_name, "MB/s", [&]() {
+                size_t words = 0;
+                forEachNormalizedWord(corpus.text, [&](std::string_view) { words++; }, simd);
+                if(words == 0) std::abort();
+                return corpus.text.size() / 1e6;
+            });
+            runBench(args, std::string("tokenize/") + level_name + "/utf8", "MB/s", [&]() {
+                size_t words = 0;
+                forEachNormalizedWord(corpus.text, [&](std::string_view) { words++; }, simd,
+                                      NormalizeMode::Utf8);
+                if(words == 0) std::abort();
+                return corpus.text.size() / 1e6;
+            });
+        }
+
+        // --- ReducerData::addWord sub 1..N threaduri ---
+        TermDictionary dict;
+        std::vector<TermId> ids;
+        for(const auto& word : corpus.vocabulary) {
+            ids.push_back(dict.intern(word, hashWord(word)));
+        }
+        std::vector<TermId> terms;
+        for(uint32_t w : corpus.stream) terms.push_back(ids[w]);
+        const size_t file_words = 5000; // "fisierele" au cate 5000 de cuvinte
+        std::vector<int> thread_counts; // 1, 2, 4, ... si --threads
+        for(int t = 1; t < args.threads; t *= 2) thread_counts.push_back(t);
+        thread_counts.push_back(args.threads);
+        for(auto backend : {IndexBackend::Map, IndexBackend::Hash}) {
+            for(int threads : thread_counts) {
+                std::string name = std::string("addWord/") + (backend == IndexBackend::Map ? "map" : "hash") +
+                                   "/" + std::to_string(threads) + "t";
+                runBench(args, name, "Mop/s", [&]() {
+                    auto data = makeReducerData(backend);
+                    std::vector<std::thread> workers;
+                    for(int t = 0; t < threads; t++) {
+                        workers.emplace_back([&, t]() {
+                            for(size_t i = t * file_words; i < terms.size(); i += threads * file_words) {
+                                int file_id = static_cast<int>(i / file_words) + 1;
+                                size_t end = std::min(terms.size(), i + file_words);
+                                for(size_t k = i; k < end; k++) data->addWord(terms[k], file_id);
+                            }
+                        });
+                    }
+                    for(auto& worker : workers) worker.join();
+                    return terms.size() / 1e6;
+                });
+            }
+        }
+
+        // --- sortarea cuvintelor: compareWords vs. counting sort ---
+        std::vector<IndexEntry> entries;
+        {
+            auto data = makeReducerData(IndexBackend::Hash);
+            for(size_t i = 0; i < terms.size(); i++) {
+                data->addWord(terms[i], static_cast<int>(i / file_words) + 1);
+            }
+            entries = data->takeEntries();
+        }
+        // copia nesortata se face in afara timpului masurat
+        std::vector<IndexEntry> words;
+        auto copyEntries = [&]() { words = entries; };
+        runBench(args, "sort/compareWords", "Mcuv/s", [&]() {
+            std::sort(words.begin(), words.end(), [&dict](const IndexEntry& a, const IndexEntry& b) {
+                return compareWords(a, b, dict);
+            });
+            return words.size() / 1e6;
+        }, copyEntries);
+        runBench(args, "sort/sortWords", "Mcuv/s", [&]() {
+            sortWords(words, dict);
+            return words.size() / 1e6;
+        }, copyEntries);
+
+        // --- formatarea iesirii ---
+        sortWords(entries, dict);
+        size_t output_bytes = 0;
+        for(const auto& entry : entries) {
+            output_bytes += dict.resolve(entry.first).size() + 4;
+            entry.second.forEach([&](int id) { output_bytes += std::to_string(id).size() + 1; });
+        }
+        OutputWriter writer;
+        runBench(args, "output/OutputWriter", "MB/s", [&]() {
+            if(!writer.writeFile("/dev/null", entries, dict)) std::abort();
+            return output_bytes / 1e6;
+        });
+        return EXIT_SUCCESS;
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Eroare: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
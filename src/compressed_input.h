@@ -0,0 +1,159 @@
+#ifndef COMPRESSED_INPUT_H
+#define COMPRESSED_INPUT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#if defined(__has_include)
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define COMPRESSED_INPUT_ZSTD 1
+#endif
+#endif
+
+// Fisiere de intrare comprimate (gzip sau zstd), recunoscute dupa primii
+// octeti, nu dupa extensie. Mapperul decomprima in flux, bloc cu bloc, in
+// acelasi buffer refolosit, direct in tokenizator: nu se scrie niciun fisier
+// temporar si textul decomprimat nu exista niciodata intreg in memorie.
+// Suportul zstd se compileaza doar daca exista <zstd.h> (vezi Makefile).
+
+// dimensiunea unui bloc decomprimat
+const size_t DECOMPRESS_BLOCK_SIZE = 256 * 1024;
+
+enum class Compression {
+    None,
+    Gzip,
+    Zstd
+};
+
+// formatul dupa octetii magici de la inceputul datelor
+inline Compression detectCompression(std::string_view data) {
+    if(data.size() >= 2 && static_cast<unsigned char>(data[0]) == 0x1F
+       && static_cast<unsigned char>(data[1]) == 0x8B) {
+        return Compression::Gzip;
+    }
+    if(data.size() >= 4 && std::memcmp(data.data(), "\x28\xB5\x2F\xFD", 4) == 0) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+// formatul unui fisier, citind doar primii lui octeti
+inline Compression detectFileCompression(const std::string& file_name) {
+    int fd = ::open(file_name.c_str(), O_RDONLY);
+    if(fd < 0) {
+        return Compression::None;
+    }
+    char magic[4];
+    ssize_t n = ::pread(fd, magic, sizeof(magic), 0);
+    ::close(fd);
+    return n > 0 ? detectCompression(std::string_view(magic, static_cast<size_t>(n)))
+                 : Compression::None;
+}
+
+namespace compressed_detail {
+
+// gzip, inclusiv fisiere formate din mai multi membri concatenati
+template<class F>
+bool inflateBlocks(std::string_view data, std::vector<char>& buffer, F& callback) {
+    z_stream zs{};
+    // 15 + 32: fereastra maxima, antet gzip sau zlib detectat automat
+    if(inflateInit2(&zs, 15 + 32) != Z_OK) {
+        return false;
+    }
+    const unsigned char* next = reinterpret_cast<const unsigned char*>(data.data());
+    size_t left = data.size();
+    bool ok = true;
+    bool stop = false;
+    while(ok && !stop) {
+        // avail_in e pe 32 de biti: intrarea se da in felii
+        uInt in = static_cast<uInt>(std::min<size_t>(left, 1u << 30));
+        zs.next_in = const_cast<unsigned char*>(next);
+        zs.avail_in = in;
+        zs.next_out = reinterpret_cast<unsigned char*>(buffer.data());
+        zs.avail_out = static_cast<uInt>(buffer.size());
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        size_t consumed = in - zs.avail_in;
+        next += consumed;
+        left -= consumed;
+        size_t produced = buffer.size() - zs.avail_out;
+        if(produced > 0 && !callback(std::string_view(buffer.data(), produced))) {
+            stop = true;
+        } else if(ret == Z_STREAM_END) {
+            // urmatorul membru, daca mai exista
+            if(left == 0) break;
+            ok = inflateReset(&zs) == Z_OK;
+        } else if(ret != Z_OK && !(ret == Z_BUF_ERROR && produced > 0)) {
+            ok = false; // date corupte sau trunchiate
+        } else if(left == 0 && produced == 0) {
+            ok = false; // fisier trunchiat
+        }
+    }
+    inflateEnd(&zs);
+    return ok;
+}
+
+#ifdef COMPRESSED_INPUT_ZSTD
+// zstd decomprima singur cadrele concatenate
+template<class F>
+bool zstdBlocks(std::string_view data, std::vector<char>& buffer, F& callback) {
+    ZSTD_DStream* ds = ZSTD_createDStream();
+    if(ds == nullptr) {
+        return false;
+    }
+    ZSTD_inBuffer in{data.data(), data.size(), 0};
+    size_t last = 1; // 0 dupa un cadru complet
+    bool ok = true;
+    while(ok) {
+        ZSTD_outBuffer out{buffer.data(), buffer.size(), 0};
+        last = ZSTD_decompressStream(ds, &out, &in);
+        if(ZSTD_isError(last)) {
+            ok = false;
+        } else if(out.pos > 0 && !callback(std::string_view(buffer.data(), out.pos))) {
+            break;
+        } else if(in.pos == in.size && out.pos < out.size) {
+            // intrarea s-a terminat si decodorul nu mai are nimic de scos
+            ok = last == 0;
+            break;
+        }
+    }
+    ZSTD_freeDStream(ds);
+    return ok;
+}
+#endif
+
+} // namespace compressed_detail
+
+// Decomprima datele bloc cu bloc in buffer (redimensionat la
+// DECOMPRESS_BLOCK_SIZE) si apeleaza callback(std::string_view) pentru
+// fiecare bloc; callback-ul intoarce false ca sa opreasca decomprimarea.
+// Intoarce false pentru date corupte sau un format nesuportat.
+template<class F>
+bool forEachDecompressedBlock(std::string_view data, Compression format,
+                              std::vector<char>& buffer, F&& callback) {
+    if(buffer.size() < DECOMPRESS_BLOCK_SIZE) {
+        buffer.resize(DECOMPRESS_BLOCK_SIZE);
+    }
+    switch(format) {
+    case Compression::Gzip:
+        return compressed_detail::inflateBlocks(data, buffer, callback);
+#ifdef COMPRESSED_INPUT_ZSTD
+    case Compression::Zstd:
+        return compressed_detail::zstdBlocks(data, buffer, callback);
+#endif
+    case Compression::None:
+        callback(data);
+        return true;
+    default:
+        return false;
+    }
+}
+
+#endif // COMPRESSED_INPUT_H
@@ -0,0 +1,115 @@
+#ifndef CONCURRENT_HASH_INDEX_H
+#define CONCURRENT_HASH_INDEX_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "postings.h"
+#include "run_stats.h"
+#include "term_dictionary.h"
+
+// Tabela hash concurenta cu adresare deschisa (linear probing), impartita
+// in stripe-uri. Fiecare stripe are propriul mutex si propria tabela, deci
+// mapperii care insereaza termeni diferiti se blocheaza rar intre ei.
+// Cheile sunt TermId-uri (sirurile stau in TermDictionary), iar ordinea
+// termenilor se impune doar la scrierea rezultatului.
+class ConcurrentHashIndex {
+private:
+    static const size_t NUM_STRIPES = 64; // putere a lui 2
+    static const size_t INITIAL_CAPACITY = 256; // sloturi per stripe, putere a lui 2
+
+    struct Slot {
+        uint32_t key = 0; // term + 1; 0 inseamna slot liber
+        Postings files;
+    };
+
+    // fiecare stripe pe propria linie de cache, ca lock-urile sa nu se "bata"
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        std::unique_ptr<Slot[]> slots;
+        size_t capacity = 0;
+        size_t size = 0;
+    };
+
+    std::unique_ptr<Stripe[]> stripes;
+
+    // amesteca bitii id-ului (id-urile consecutive ar umple acelasi stripe)
+    static uint64_t mix(uint32_t key) {
+        uint64_t h = key * 0x9e3779b97f4a7c15ull;
+        return h ^ (h >> 29);
+    }
+
+    static Slot* findSlot(Slot* slots, size_t capacity, uint32_t key) {
+        size_t mask = capacity - 1;
+        for(size_t i = mix(key) & mask;; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if(slot.key == 0 || slot.key == key) {
+                return &slot;
+            }
+        }
+    }
+
+    // dubleaza tabela stripe-ului (apelat cu lock-ul stripe-ului luat)
+    static void grow(Stripe& stripe) {
+        size_t new_capacity = stripe.capacity * 2;
+        std::unique_ptr<Slot[]> new_slots(new Slot[new_capacity]);
+        for(size_t i = 0; i < stripe.capacity; i++) {
+            Slot& old = stripe.slots[i];
+            if(old.key == 0) continue;
+            Slot* dst = findSlot(new_slots.get(), new_capacity, old.key);
+            dst->key = old.key;
+            dst->files = std::move(old.files);
+        }
+        stripe.slots = std::move(new_slots);
+        stripe.capacity = new_capacity;
+    }
+
+public:
+    ConcurrentHashIndex() : stripes(new Stripe[NUM_STRIPES]) {
+        for(size_t s = 0; s < NUM_STRIPES; s++) {
+            stripes[s].slots.reset(new Slot[INITIAL_CAPACITY]);
+            stripes[s].capacity = INITIAL_CAPACITY;
+        }
+    }
+
+    // adauga aparitia termenului in fisierul dat
+    void add(TermId term, int file_id) {
+        uint32_t key = term + 1;
+        Stripe& stripe = stripes[mix(key) >> 58 & (NUM_STRIPES - 1)];
+        stats::CountedLock lock(stripe.mutex, stats::ReducerLock);
+
+        Slot* slot = findSlot(stripe.slots.get(), stripe.capacity, key);
+        if(slot->key == 0) {
+            // factor de incarcare maxim 0.75
+            if((stripe.size + 1) * 4 > stripe.capacity * 3) {
+                grow(stripe);
+                slot = findSlot(stripe.slots.get(), stripe.capacity, key);
+            }
+            slot->key = key;
+            stripe.size++;
+        }
+        slot->files.insert(file_id);
+    }
+
+    // parcurge toate intrarile (in ordinea din tabela), iar callback-ul
+    // poate muta postarile; tabelele se elibereaza stripe cu stripe, deci
+    // se apeleaza o singura data, dupa terminarea inserarilor
+    template<class F>
+    void drain(F&& callback) {
+        for(size_t s = 0; s < NUM_STRIPES; s++) {
+            Stripe& stripe = stripes[s];
+            for(size_t i = 0; i < stripe.capacity; i++) {
+                Slot& slot = stripe.slots[i];
+                if(slot.key != 0) {
+                    callback(static_cast<TermId>(slot.key - 1), slot.files);
+                }
+            }
+            stripe.slots.reset(new Slot[INITIAL_CAPACITY]);
+            stripe.capacity = INITIAL_CAPACITY;
+            stripe.size = 0;
+        }
+    }
+};
+
+#endif // CONCURRENT_HASH_INDEX_H
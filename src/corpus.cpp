@@ -0,0 +1,460 @@
+// Generator de corpusuri sintetice si sweep de scalare pentru tema1.
+//
+// ./corpus generate <director> <MB> [optiuni de generare]
+// ./corpus sweep <director_lucru> [--sizes=MB,...] [--mappers=M,...]
+//         [--reducers=R,...] [--repeats=N] [--csv=fisier] [--tema1=cale]
+//         [--cleanup] [optiuni de generare] [-- optiuni pentru tema1]
+//
+// Optiuni de generare: --vocabulary=N, --zipf=S, --file-size=KB,
+// --spread=S, --letter-skew=S, --seed=N, --threads=N.
+//
+// generate scrie fisierele corpusului si lista lor (<director>/input.txt, in
+// formatul primit de tema1). sweep genereaza cate un corpus pentru fiecare
+// dimensiune (sau il refoloseste, daca exista deja unul cu aceleasi optiuni
+// de generare), ruleaza tema1 pentru fiecare combinatie M x R si adauga cate
+// o linie in CSV: optiunile corpusului, timpul, debitul, timpul CPU si
+// memoria maxima (RSS) a procesului.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+struct GenOptions {
+    size_t vocabulary = 200000;
+    double zipf = 1.0; // exponentul distributiei frecventelor
+    double file_kb = 256; // dimensiunea medie a unui fisier
+    double spread = 1.0; // sigma distributiei log-normale a dimensiunilor
+    double letter_skew = 1.0; // 0 = prima litera uniforma, 1 = ca in engleza
+    uint64_t seed = 1;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+};
+
+// Frecventa (aproximativa, in procente) primei litere a cuvintelor din textele
+// in engleza
+const double FIRST_LETTER_WEIGHTS[26] = {
+    11.7, 4.4, 5.2, 3.2, 2.8, 4.0, 1.6, 4.2, 7.3, 0.51, 0.86, 2.4, 3.8,
+    2.3, 7.6, 4.3, 0.22, 2.8, 6.7, 16.0, 1.2, 0.82, 5.5, 0.045, 0.76, 0.045};
+
+// Esantionare O(1) dintr-o distributie discreta (metoda alias a lui Vose)
+class AliasTable {
+private:
+    std::vector<double> probability;
+    std::vector<uint32_t> alias;
+
+public:
+    explicit AliasTable(const std::vector<double>& weights) : probability(weights.size()), alias(weights.size()) {
+        double total = 0;
+        for(double w : weights) total += w;
+        std::vector<double> scaled(weights.size());
+        std::vector<uint32_t> small, large;
+        for(size_t i = 0; i < weights.size(); i++) {
+            scaled[i] = weights[i] * weights.size() / total;
+            (scaled[i] < 1 ? small : large).push_back(static_cast<uint32_t>(i));
+        }
+        while(!small.empty() && !large.empty()) {
+            uint32_t s = small.back(), l = large.back();
+            small.pop_back();
+            probability[s] = scaled[s];
+            alias[s] = l;
+            scaled[l] -= 1 - scaled[s];
+            if(scaled[l] < 1) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        for(uint32_t i : small) probability[i] = 1;
+        for(uint32_t i : large) probability[i] = 1;
+    }
+
+    template<class Rng>
+    uint32_t sample(Rng& rng) const {
+        uint64_t r = rng();
+        uint32_t column = static_cast<uint32_t>((r >> 32) % probability.size());
+        double coin = (r & 0xffffffff) / 4294967296.0;
+        return coin < probability[column] ? column : alias[column];
+    }
+};
+
+// Vocabularul: cuvinte distincte de 2..14 litere, prima litera dupa
+// FIRST_LETTER_WEIGHTS^letter_skew; cuvintele sunt in ordine aleatoare, deci
+// rangul Zipf (pozitia) nu depinde de litera
+std::vector<std::string> makeVocabulary(const GenOptions& options) {
+    std::mt19937_64 rng(options.seed);
+    std::vector<double> letter_weights(26);
+    for(int c = 0; c < 26; c++) {
+        letter_weights[c] = std::pow(FIRST_LETTER_WEIGHTS[c], options.letter_skew);
+    }
+    AliasTable first_letter(letter_weights);
+    std::binomial_distribution<int> length(12, 0.4);
+    std::uniform_int_distribution<int> letter(0, 25);
+
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> words;
+    words.reserve(options.vocabulary);
+    while(words.size() < options.vocabulary) {
+        std::string word(1, static_cast<char>('a' + first_letter.sample(rng)));
+        int n = 2 + length(rng);
+        while(static_cast<int>(word.size()) < n) word += static_cast<char>('a' + letter(rng));
+        if(seen.insert(word).second) words.push_back(word);
+    }
+    return words;
+}
+
+// Genereaza textul unui fisier: cuvinte cu frecvente Zipf, cu majuscule,
+// punctuatie si randuri noi presarate, pana la target octeti
+template<class Rng>
+void makeText(const std::vector<std::string>& words, const AliasTable& zipf,
+              size_t target, Rng& rng, std::string& text) {
+    static const char punctuation[] = ",.;:!?";
+    text.clear();
+    while(text.size() < target) {
+        const std::string& word = words[zipf.sample(rng)];
+        uint32_t noise = static_cast<uint32_t>(rng() & 0xff);
+        size_t start = text.size();
+        if(noise < 4) text += '"';
+        text += word;
+        if(noise < 16) text[start + (noise < 4)] -= 32; // majuscula
+        if(noise >= 16 && noise < 24) text += "'s";
+        if(noise >= 24 && noise < 48) text += punctuation[noise % 6];
+        text += noise >= 232 ? '\n' : ' ';
+    }
+}
+
+// Genereaza corpusul in directorul dat si intoarce calea listei de fisiere
+std::string generateCorpus(const std::string& dir, double megabytes, const GenOptions& options) {
+    fs::create_directories(dir);
+    std::string root = fs::absolute(dir).string();
+
+    std::vector<std::string> words = makeVocabulary(options);
+    std::vector<double> frequencies(words.size());
+    for(size_t i = 0; i < words.size(); i++) {
+        frequencies[i] = 1.0 / std::pow(i + 1, options.zipf);
+    }
+    AliasTable zipf(frequencies);
+
+    // dimensiunile fisierelor: log-normale, cu media file_kb
+    std::mt19937_64 rng(options.seed ^ 0x9e3779b97f4a7c15ULL);
+    double mu = std::log(options.file_kb * 1024) - options.spread * options.spread / 2;
+    std::lognormal_distribution<double> file_size(mu, options.spread);
+    uint64_t target = static_cast<uint64_t>(megabytes * 1024 * 1024), total = 0;
+    std::vector<size_t> sizes;
+    while(total < target) {
+        size_t size = std::max<size_t>(static_cast<size_t>(file_size(rng)), 1024);
+        size = std::min<uint64_t>(size, target - total);
+        sizes.push_back(size);
+        total += size;
+    }
+
+    auto pathOf = [&root](size_t i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/file_%06zu.txt", i + 1);
+        return root + name;
+    };
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+    for(int t = 0; t < options.threads; t++) {
+        workers.emplace_back([&]() {
+            std::string text;
+            for(size_t i; (i = next.fetch_add(1)) < sizes.size() && !failed;) {
+                std::mt19937_64 file_rng(options.seed * 1000003 + i);
+                makeText(words, zipf, sizes[i], file_rng, text);
+                std::FILE* file = std::fopen(pathOf(i).c_str(), "wb");
+                if(file == nullptr || std::fwrite(text.data(), 1, text.size(), file) != text.size()) {
+                    failed = true;
+                }
+                if(file != nullptr && std::fclose(file) != 0) {
+                    failed = true;
+                }
+            }
+        });
+    }
+    for(auto& worker : workers) worker.join();
+    if(failed) {
+        throw std::runtime_error("Eroare la scrierea corpusului in " + root);
+    }
+
+    // lista se scrie ultima: existenta ei inseamna un corpus complet
+    std::string list = root + "/input.txt";
+    std::ofstream out(list);
+    out << sizes.size() << "\n";
+    for(size_t i = 0; i < sizes.size(); i++) out << pathOf(i) << "\n";
+    if(!out.flush()) {
+        throw std::runtime_error("Eroare la scrierea listei " + list);
+    }
+    return list;
+}
+
+// Optiunile care determina continutul corpusului (fara --threads), ca sir
+// folosit in numele directorului din sweep si in coloana corpus din CSV
+std::string describeCorpus(const GenOptions& options) {
+    char text[160];
+    std::snprintf(text, sizeof(text), "v%zu_z%g_f%g_s%g_k%g_seed%llu", options.vocabulary,
+                  options.zipf, options.file_kb, options.spread, options.letter_skew,
+                  static_cast<unsigned long long>(options.seed));
+    return text;
+}
+
+// Returneaza numarul de fisiere si dimensiunea totala a unui corpus
+void corpusStats(const std::string& list, size_t& files, uint64_t& bytes) {
+    std::ifstream in(list);
+    in >> files;
+    bytes = 0;
+    std::string path;
+    for(size_t i = 0; i < files && in >> path; i++) {
+        std::error_code error;
+        uintmax_t size = fs::file_size(path, error);
+        if(!error) bytes += size;
+    }
+}
+
+struct RunResult {
+    double seconds = 0;
+    double cpu_seconds = 0;
+    long peak_rss_kb = 0;
+    int status = -1;
+};
+
+// Ruleaza tema1 in directorul out (unde se scriu literele) si masoara
+// timpul, CPU-ul si RSS-ul maxim al procesului copil
+RunResult runTema1(const std::string& tema1, const std::string& list, int mappers, int reducers,
+                   const std::vector<std::string>& extra, const std::string& out) {
+    fs::remove_all(out);
+    fs::create_directories(out);
+    std::vector<std::string> args = {tema1, std::to_string(mappers), std::to_string(reducers), list};
+    args.insert(args.end(), extra.begin(), extra.end());
+    std::vector<char*> argv;
+    for(auto& arg : args) argv.push_back(arg.data());
+    argv.push_back(nullptr);
+
+    RunResult result;
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if(pid < 0) {
+        throw std::runtime_error("fork a esuat");
+    }
+    if(pid == 0) {
+        // stdout-ul lui tema1 nu intereseaza; erorile raman pe stderr
+        int null_fd = open("/dev/null", O_WRONLY);
+        if(null_fd >= 0) dup2(null_fd, STDOUT_FILENO);
+        if(chdir(out.c_str()) == 0) {
+            execv(argv[0], argv.data());
+        }
+        _exit(127);
+    }
+    int status = 0;
+    struct rusage usage{};
+    if(wait4(pid, &status, 0, &usage) < 0) {
+        throw std::runtime_error("wait4 a esuat");
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.cpu_seconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    result.peak_rss_kb = usage.ru_maxrss;
+    result.status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    return result;
+}
+
+std::vector<double> parseList(const std::string& value) {
+    std::vector<double> values;
+    size_t start = 0;
+    while(start <= value.size()) {
+        size_t comma = value.find(',', start);
+        if(comma == std::string::npos) comma = value.size();
+        values.push_back(std::stod(value.substr(start, comma - start)));
+        if(values.back() <= 0) {
+            throw std::invalid_argument("Valorile din liste trebuie sa fie pozitive: " + value);
+        }
+        start = comma + 1;
+    }
+    return values;
+}
+
+// Interpreteaza o optiune de generare; false daca nu este una
+bool parseGenOption(const std::string& name, const std::string& value, GenOptions& options) {
+    if(name == "--vocabulary") {
+        options.vocabulary = std::stoul(value);
+    } else if(name == "--zipf") {
+        options.zipf = std::stod(value);
+    } else if(name == "--file-size") {
+        options.file_kb = std::stod(value);
+    } else if(name == "--spread") {
+        options.spread = std::stod(value);
+    } else if(name == "--letter-skew") {
+        options.letter_skew = std::stod(value);
+    } else if(name == "--seed") {
+        options.seed = std::stoull(value);
+    } else if(name == "--threads") {
+        options.threads = std::stoi(value);
+    } else {
+        return false;
+    }
+    if(options.vocabulary == 0 || options.file_kb < 1 || options.threads <= 0 ||
+       options.spread < 0 || options.zipf < 0 || options.letter_skew < 0) {
+        throw std::invalid_argument("Valoare invalida pentru " + name + ": " + value);
+    }
+    return true;
+}
+
+int runGenerate(int argc, char** argv) {
+    if(argc < 4) {
+        throw std::invalid_argument("Utilizare: generate <director> <MB> [optiuni]");
+    }
+    GenOptions options;
+    for(int i = 4; i < argc; i++) {
+        std::string option = argv[i];
+        size_t eq = option.find('=');
+        if(eq == std::string::npos || !parseGenOption(option.substr(0, eq), option.substr(eq + 1), options)) {
+            throw std::invalid_argument("Optiune necunoscuta: " + option);
+        }
+    }
+    double megabytes = std::stod(argv[3]);
+    if(megabytes <= 0) {
+        throw std::invalid_argument("Dimensiunea corpusului trebuie sa fie pozitiva");
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::string list = generateCorpus(argv[2], megabytes, options);
+    size_t files;
+    uint64_t bytes;
+    corpusStats(list, files, bytes);
+    std::cout << list << ": " << files << " fisiere, " << bytes / 1e6 << " MB in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+              << " s" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int runSweep(int argc, char** argv) {
+    if(argc < 3) {
+        throw std::invalid_argument("Utilizare: sweep <director_lucru> [optiuni] [-- optiuni tema1]");
+    }
+    std::string work = argv[2];
+    std::vector<double> sizes = {100}, mappers = {1, 2, 4, 8}, reducers = {1, 2, 4, 8};
+    int repeats = 1;
+    std::string csv = "sweep.csv", tema1 = "./tema1";
+    bool cleanup = false;
+    GenOptions options;
+    std::vector<std::string> extra;
+    for(int i = 3; i < argc; i++) {
+        std::string option = argv[i];
+        if(option == "--") {
+            extra.assign(argv + i + 1, argv + argc);
+            break;
+        }
+        size_t eq = option.find('=');
+        std::string name = option.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
+        if(name == "--sizes") {
+            sizes = parseList(value);
+        } else if(name == "--mappers") {
+            mappers = parseList(value);
+        } else if(name == "--reducers") {
+            reducers = parseList(value);
+        } else if(name == "--repeats") {
+            repeats = std::stoi(value);
+        } else if(name == "--csv") {
+            csv = value;
+        } else if(name == "--tema1") {
+            tema1 = value;
+        } else if(option == "--cleanup") {
+            cleanup = true;
+        } else if(!parseGenOption(name, value, options)) {
+            throw std::invalid_argument("Optiune necunoscuta: " + option);
+        }
+    }
+    if(repeats <= 0) {
+        throw std::invalid_argument("--repeats trebuie sa fie pozitiv");
+    }
+    tema1 = fs::absolute(tema1).string();
+    if(access(tema1.c_str(), X_OK) != 0) {
+        std::cerr << "Executabil inexistent: " << tema1 << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool header = !fs::exists(csv);
+    std::ofstream out(csv, std::ios::app);
+    if(!out.is_open()) {
+        std::cerr << "Eroare la deschiderea fisierului CSV: " << csv << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::string options_column;
+    for(const auto& arg : extra) options_column += (options_column.empty() ? "" : " ") + arg;
+    std::string corpus = describeCorpus(options);
+    if(header) {
+        out << "size_mb,corpus,bytes,files,mappers,reducers,options,repeat,seconds,mb_per_s,cpu_seconds,peak_rss_kb,status\n";
+    }
+
+    for(double size : sizes) {
+        // optiunile de generare fac parte din nume, deci un corpus se
+        // refoloseste doar pentru exact aceleasi optiuni
+        char name[64];
+        std::snprintf(name, sizeof(name), "/corpus_%gMB_", size);
+        std::string dir = fs::absolute(work).string() + name + corpus;
+        std::string list = dir + "/input.txt";
+        if(!fs::exists(list)) {
+            std::cout << "generez " << dir << std::endl;
+            generateCorpus(dir, size, options);
+        }
+        size_t files;
+        uint64_t bytes;
+        corpusStats(list, files, bytes);
+
+        for(double m : mappers) {
+            for(double r : reducers) {
+                for(int repeat = 1; repeat <= repeats; repeat++) {
+                    RunResult result = runTema1(tema1, list, static_cast<int>(m), static_cast<int>(r),
+                                                extra, fs::absolute(work).string() + "/out");
+                    double rate = bytes / 1e6 / result.seconds;
+                    out << size << "," << corpus << "," << bytes << "," << files << "," << m << "," << r << ",\""
+                        << options_column << "\"," << repeat << "," << result.seconds << "," << rate << ","
+                        << result.cpu_seconds << "," << result.peak_rss_kb << "," << result.status << "\n";
+                    out.flush();
+                    std::printf("%8gMB M=%-3g R=%-3g #%d  %8.3f s  %8.1f MB/s  %8.1f MB RSS%s\n",
+                                size, m, r, repeat, result.seconds, rate, result.peak_rss_kb / 1024.0,
+                                result.status == 0 ? "" : "  (eroare)");
+                    std::fflush(stdout);
+                }
+            }
+        }
+        if(cleanup) {
+            fs::remove_all(dir);
+        }
+    }
+    fs::remove_all(fs::absolute(work).string() + "/out");
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::string command = argc >= 2 ? argv[1] : "";
+        if(command == "generate") {
+            return runGenerate(argc, argv);
+        }
+        if(command == "sweep") {
+            return runSweep(argc, argv);
+        }
+        throw std::invalid_argument("Utilizare: corpus generate|sweep ...");
+    }
+    catch(const std::exception& e) {
+        std::cerr << "Eroare: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,326 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+
+#include "index_file.h"
+#include "input_reader.h"
+#include "term_dictionary.h"
+
+// Indexarea incrementala. Directorul indexului contine un manifest si
+// segmente in formatul indexului binar (index_file.h). Fiecare fisier
+// indexat primeste un numar de document (doc) stabil intre rulari; postarile
+// din segmente folosesc aceste numere, nu pozitiile din fisierul de intrare.
+// La fiecare rulare se mapeaza doar fisierele noi sau modificate, intr-un
+// segment nou (delta). Un fisier modificat primeste un doc nou, iar cel vechi
+// devine mort si dispare din segmente la urmatoarea compactare. Segmentele se
+// compacteaza ca intr-un LSM: ultimele doua se unesc cat timp penultimul nu e
+// de mult mai mare decat ultimul, sau cand sunt prea multe segmente.
+
+// Intrarea manifestului pentru un fisier indexat
+struct ManifestFile {
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    uint64_t hash = 0; // hashWord peste continutul fisierului
+    uint32_t doc = 0;
+};
+
+// Un fisier care trebuie (re)indexat in segmentul delta
+struct DeltaFile {
+    std::string path;
+    uint32_t doc;
+};
+
+class Manifest {
+public:
+    // compactarea se face si cand sunt mai mult de atatea segmente
+    static const size_t MAX_SEGMENTS = 8;
+
+private:
+    std::string dir;
+    std::vector<ManifestFile> files; // in ordinea din fisierul de intrare
+    std::vector<std::string> segments; // de la cel mai vechi la cel mai nou
+    uint32_t next_doc = 1;
+    uint32_t next_segment = 1;
+
+    static const char* header() {
+        return "tema1-manifest 1";
+    }
+
+    static bool statFile(const std::string& path, uint64_t& size, int64_t& mtime_ns) {
+        struct stat st{};
+        if(stat(path.c_str(), &st) != 0) {
+            return false;
+        }
+        size = st.st_size;
+        mtime_ns = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        return true;
+    }
+
+    static uint64_t hashContents(const std::string& path) {
+        MappedFile file(path);
+        return file.isOpen() ? hashWord(file.data()) : 0;
+    }
+
+public:
+    explicit Manifest(std::string directory) : dir(std::move(directory)) {}
+
+    std::string pathOf(const std::string& segment) const {
+        return dir + "/" + segment;
+    }
+
+    const std::vector<std::string>& segmentNames() const {
+        return segments;
+    }
+
+    // citeste manifestul; un director fara manifest inseamna index gol
+    bool load() {
+        std::ifstream in(pathOf("manifest"));
+        if(!in.is_open()) {
+            return true;
+        }
+        std::string line;
+        if(!std::getline(in, line) || line != header()) {
+            return false;
+        }
+        std::string kind;
+        while(in >> kind) {
+            if(kind == "next") {
+                in >> next_doc >> next_segment;
+            } else if(kind == "segment") {
+                std::string name;
+                in >> name;
+                segments.push_back(name);
+            } else if(kind == "file") {
+                ManifestFile file;
+                in >> file.doc >> file.size >> file.mtime_ns >> std::hex >> file.hash >> std::dec >> file.path;
+                files.push_back(file);
+            } else {
+                return false;
+            }
+            if(in.fail()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // scrie manifestul atomic (fisier temporar + rename)
+    bool save() const {
+        std::string tmp = pathOf("manifest.tmp");
+        {
+            std::ofstream out(tmp);
+            if(!out.is_open()) {
+                return false;
+            }
+            out << header() << "\n";
+            out << "next " << next_doc << " " << next_segment << "\n";
+            for(const auto& segment : segments) {
+                out << "segment " << segment << "\n";
+            }
+            for(const auto& file : files) {
+                out << "file " << file.doc << " " << file.size << " " << file.mtime_ns << " "
+                    << std::hex << file.hash << std::dec << " " << file.path << "\n";
+            }
+            if(!out.flush()) {
+                return false;
+            }
+        }
+        return std::rename(tmp.c_str(), pathOf("manifest").c_str()) == 0;
+    }
+
+    // compara lista curenta de fisiere cu manifestul: fisierele noi sau
+    // modificate primesc doc-uri noi si se intorc pentru indexare; doc_map
+    // primeste pentru fiecare doc pozitia (1-based) a fisierului in lista,
+    // sau 0 pentru doc-urile moarte
+    std::vector<DeltaFile> update(const std::vector<std::string>& paths, std::vector<uint32_t>& doc_map) {
+        // un fisier poate aparea de mai multe ori in lista; aparitiile se
+        // potrivesc in ordine cu intrarile vechi
+        std::unordered_map<std::string, std::vector<size_t>> previous;
+        for(size_t i = files.size(); i-- > 0;) {
+            previous[files[i].path].push_back(i);
+        }
+
+        std::vector<ManifestFile> current;
+        std::vector<DeltaFile> delta;
+        for(const auto& path : paths) {
+            ManifestFile file;
+            file.path = path;
+            if(!statFile(path, file.size, file.mtime_ns)) {
+                file.size = 0;
+                file.mtime_ns = -1;
+            }
+
+            auto it = previous.find(path);
+            if(it != previous.end() && !it->second.empty()) {
+                const ManifestFile& old = files[it->second.back()];
+                it->second.pop_back();
+                bool same = old.size == file.size && old.mtime_ns == file.mtime_ns;
+                if(!same && old.size == file.size) {
+                    // doar mtime difera: continutul decide
+                    file.hash = hashContents(path);
+                    same = file.hash == old.hash;
+                }
+                if(same) {
+                    file.hash = old.hash;
+                    file.doc = old.doc;
+                    current.push_back(file);
+                    continue;
+                }
+            }
+            if(file.hash == 0) {
+                file.hash = hashContents(path);
+            }
+            file.doc = next_doc++;
+            delta.push_back({path, file.doc});
+            current.push_back(file);
+        }
+
+        files.swap(current);
+        doc_map.assign(next_doc, 0);
+        for(size_t i = 0; i < files.size(); i++) {
+            doc_map[files[i].doc] = static_cast<uint32_t>(i + 1);
+        }
+        return delta;
+    }
+
+    // numele urmatorului segment (fisierul lui se scrie inainte de addSegment)
+    std::string newSegmentName() {
+        return "seg-" + std::to_string(next_segment++) + ".bin";
+    }
+
+    void addSegment(const std::string& name) {
+        segments.push_back(name);
+    }
+
+    // inlocuieste ultimele count segmente cu segmentul compactat
+    void replaceLast(size_t count, const std::string& name) {
+        segments.resize(segments.size() - count);
+        segments.push_back(name);
+    }
+
+    // cel mai mare doc alocat pana acum
+    uint32_t maxDoc() const {
+        return next_doc - 1;
+    }
+};
+
+// Interclaseaza termenii care incep cu litera data din toate segmentele.
+// Id-urile se traduc prin doc_map (0 = doc mort, se ignora); pentru fiecare
+// termen care ramane cu postari, callback(word, ids) primeste id-urile
+// crescatoare. Termenii se parcurg alfabetic.
+template<class F>
+void mergeSegmentLetter(const std::vector<const IndexFile*>& segments,
+                        char letter,
+                        const std::vector<uint32_t>& doc_map,
+                        F&& callback) {
+    std::string from(1, letter), to(1, static_cast<char>(letter + 1));
+    std::vector<uint32_t> pos(segments.size()), end(segments.size());
+    for(size_t s = 0; s < segments.size(); s++) {
+        pos[s] = segments[s]->lowerBound(from);
+        // termenii non-ASCII sunt ultimii din tabela
+        end[s] = letter == OTHER_LETTER ? segments[s]->size() : segments[s]->lowerBound(to);
+    }
+
+    std::vector<uint32_t> ids;
+    for(;;) {
+        // cel mai mic termen dintre cursoarele segmentelor
+        std::string_view word;
+        bool found = false;
+        for(size_t s = 0; s < segments.size(); s++) {
+            if(pos[s] < end[s] && (!found || segments[s]->term(pos[s]) < word)) {
+                word = segments[s]->term(pos[s]);
+                found = true;
+            }
+        }
+        if(!found) {
+            return;
+        }
+
+        ids.clear();
+        for(size_t s = 0; s < segments.size(); s++) {
+            if(pos[s] < end[s] && segments[s]->term(pos[s]) == word) {
+                segments[s]->forEachPosting(pos[s], [&](uint32_t doc) {
+                    uint32_t id = doc < doc_map.size() ? doc_map[doc] : 0;
+                    if(id != 0) ids.push_back(id);
+                });
+                pos[s]++;
+            }
+        }
+        if(ids.empty()) {
+            continue;
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        callback(word, ids);
+    }
+}
+
+// Compacteaza segmentele manifestului (politica LSM cu niveluri dupa
+// dimensiune) si intoarce false la o eroare de scriere. doc_map[doc] != 0
+// pentru doc-urile inca vii; doc-urile moarte se elimina doar din segmentele
+// unite acum. Un segment care nu intra in compactare (de obicei cel de baza,
+// mult mai mare) isi pastreaza postarile moarte pana cand raportul
+// dimensiunilor il aduce intr-o unire; pana atunci le filtreaza citirea.
+inline bool compactSegments(Manifest& manifest, const std::vector<uint32_t>& doc_map) {
+    auto sizeOf = [&manifest](const std::string& name) {
+        struct stat st{};
+        return stat(manifest.pathOf(name).c_str(), &st) == 0 ? uint64_t(st.st_size) : 0;
+    };
+
+    for(;;) {
+        const auto& names = manifest.segmentNames();
+        size_t n = names.size();
+        if(n < 2) {
+            return true;
+        }
+        // ultimele doua segmente se unesc daca penultimul e cel mult de doua
+        // ori mai mare, sau daca sunt prea multe segmente
+        if(sizeOf(names[n - 2]) > 2 * sizeOf(names[n - 1]) && n <= Manifest::MAX_SEGMENTS) {
+            return true;
+        }
+
+        IndexFile older, newer;
+        if(!older.open(manifest.pathOf(names[n - 2])) || !newer.open(manifest.pathOf(names[n - 1]))) {
+            return false;
+        }
+        // doc-urile raman aceleasi; doar cele moarte dispar
+        std::vector<uint32_t> identity(doc_map.size(), 0);
+        for(uint32_t doc = 0; doc < doc_map.size(); doc++) {
+            if(doc_map[doc] != 0) identity[doc] = doc;
+        }
+
+        IndexBuilder builder;
+        std::vector<const IndexFile*> inputs = {&older, &newer};
+        for(char letter = 'a'; letter < 'a' + LETTER_SLOTS; letter++) {
+            mergeSegmentLetter(inputs, letter, identity, [&](std::string_view word, const std::vector<uint32_t>& ids) {
+                builder.addTerm(word, ids);
+            });
+        }
+
+        std::string merged = manifest.newSegmentName();
+        if(!builder.write(manifest.pathOf(merged), manifest.maxDoc())) {
+            return false;
+        }
+        std::string removed[2] = {names[n - 2], names[n - 1]};
+        manifest.replaceLast(2, merged);
+        if(!manifest.save()) {
+            return false;
+        }
+        for(const auto& name : removed) {
+            std::remove(manifest.pathOf(name).c_str());
+        }
+    }
+}
+
+#endif // INCREMENTAL_H
@@ -0,0 +1,456 @@
+#ifndef INDEX_FILE_H
+#define INDEX_FILE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "positions.h"
+#include "postings.h"
+#include "term_dictionary.h"
+#include "tokenizer.h"
+
+// Indexul binar de pe disc. Structura fisierului:
+//  * IndexHeader
+//  * tabela termenilor: num_terms x IndexTermRecord, sortata alfabetic
+//  * sirurile termenilor, concatenate (fara terminator)
+//  * postarile: pentru fiecare termen, id-urile crescatoare codificate ca
+//    diferente (primul id, apoi id[i] - id[i-1]) in varint (7 biti pe octet)
+// Toate campurile sunt little-endian, iar offset-urile sunt relative la
+// inceputul sectiunii lor, deci fisierul se poate folosi direct prin mmap.
+// Cu --positions, langa index se scrie si <index>.pos (vezi positions.h).
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_terms;
+    uint32_t num_files; // cel mai mare file_id
+    uint32_t normalize; // NormalizeMode cu care s-au normalizat termenii (0 = ascii)
+    uint64_t terms_offset;
+    uint64_t strings_offset;
+    uint64_t postings_offset;
+    uint64_t file_size;
+};
+
+struct IndexTermRecord {
+    uint64_t postings_offset;
+    uint32_t string_offset;
+    uint32_t string_length;
+    uint32_t doc_count;
+    uint32_t postings_bytes;
+};
+
+class IndexFile;
+
+const char INDEX_MAGIC[8] = {'T', 'E', 'M', 'A', '1', 'I', 'D', 'X'};
+const uint32_t INDEX_VERSION = 1;
+
+// Construieste indexul binar din literele complete. Fiecare litera are
+// propriul segment (termenii ei sortati alfabetic si postarile codificate),
+// deci literele se pot adauga in paralel din threaduri diferite; la scriere
+// segmentele se concateneaza in ordinea literelor.
+class IndexBuilder {
+private:
+    struct Term {
+        std::string_view word; // sirul din dictionar
+        uint64_t offset; // in postarile segmentului
+        uint32_t doc_count;
+        uint32_t bytes;
+        uint64_t positions_offset; // in pozitiile segmentului
+        uint64_t positions_bytes;
+    };
+
+    struct Segment {
+        std::vector<Term> terms;
+        std::vector<uint8_t> postings;
+        std::vector<uint8_t> positions;
+    };
+
+    std::vector<Segment> segments; // cate unul pentru fiecare litera
+    const PositionStore* positions = nullptr; // doar cu --positions
+
+    static bool writeAll(int fd, const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while(size > 0) {
+            ssize_t n = ::write(fd, p, size);
+            if(n < 0) return false;
+            p += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+public:
+    IndexBuilder() : segments(LETTER_SLOTS) {}
+
+    // pozitiile termenilor adaugati cu addLetter se scriu in <index>.pos
+    void setPositions(const PositionStore* store) {
+        positions = store;
+    }
+
+    // adauga cuvintele unei litere (in orice ordine); fiecare litera o data
+    void addLetter(char letter, const std::vector<IndexEntry>& words, const TermDictionary& dict) {
+        addLetter(letter, words, dict, [](const IndexEntry& entry, auto&& callback) {
+            entry.second.forEach(callback);
+        });
+    }
+
+    // varianta pentru orice tip de intrare (cu termOf si filesOf);
+    // for_each_id(entry, callback) parcurge crescator id-urile intrarii
+    template<class Entry, class F>
+    void addLetter(char letter, const std::vector<Entry>& words, const TermDictionary& dict, F&& for_each_id) {
+        Segment& segment = segments[letter - 'a'];
+        segment.terms.reserve(words.size());
+        for(const auto& entry : words) {
+            uint64_t offset = segment.postings.size();
+            uint32_t previous = 0;
+            for_each_id(entry, [&](int file_id) {
+                uint32_t id = static_cast<uint32_t>(file_id);
+                appendVarint(segment.postings, id - previous);
+                previous = id;
+            });
+            std::string_view word = dict.resolve(termOf(entry));
+            uint64_t positions_offset = segment.positions.size();
+            if(positions != nullptr) {
+                positions->append(termOf(entry), word, segment.positions);
+            }
+            segment.terms.push_back({word, offset,
+                                     static_cast<uint32_t>(filesOf(entry)),
+                                     static_cast<uint32_t>(segment.postings.size() - offset),
+                                     positions_offset, segment.positions.size() - positions_offset});
+        }
+        std::sort(segment.terms.begin(), segment.terms.end(), [](const Term& a, const Term& b) {
+            return a.word < b.word;
+        });
+    }
+
+    // adauga un singur termen, cu id-urile crescatoare; termenii unei litere
+    // trebuie adaugati in ordine alfabetica (folosit la interclasarea
+    // segmentelor, unde sirul ramane valid pana la write)
+    void addTerm(std::string_view word, const std::vector<uint32_t>& ids) {
+        Segment& segment = segments[letterOf(word) - 'a'];
+        uint64_t offset = segment.postings.size();
+        uint32_t previous = 0;
+        for(uint32_t id : ids) {
+            appendVarint(segment.postings, id - previous);
+            previous = id;
+        }
+        segment.terms.push_back({word, offset, static_cast<uint32_t>(ids.size()),
+                                 static_cast<uint32_t>(segment.postings.size() - offset), 0, 0});
+    }
+
+    // adauga literele unui index intreg, cu postarile copiate nemodificate:
+    // segmentul fiecarei litere ramane cel scris de addLetter, deci indexul
+    // rezultat e identic cu cel construit direct din litere (folosit pentru
+    // indexurile partiale ale reducerilor, cu --shuffle=process)
+    void addIndex(const IndexFile& part);
+
+    // scrie indexul; num_files este cel mai mare file_id. Un <index>.pos
+    // ramas de la o rulare anterioara se sterge daca nu se scriu pozitii.
+    bool write(const std::string& path, uint32_t num_files) const {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) {
+            return false;
+        }
+        IndexHeader header{};
+        bool ok = writeIndex(fd, num_files, header);
+        ok = ::close(fd) == 0 && ok;
+        if(positions == nullptr) {
+            ::unlink(positionsPath(path).c_str());
+            return ok;
+        }
+        return ok && writePositions(positionsPath(path), header);
+    }
+
+    // scrie indexul (fara pozitii) intr-un descriptor deschis, de la pozitia
+    // lui curenta, de exemplu un memfd (vezi --shuffle=process)
+    bool write(int fd, uint32_t num_files) const {
+        IndexHeader header{};
+        return writeIndex(fd, num_files, header);
+    }
+
+private:
+    bool writeIndex(int fd, uint32_t num_files, IndexHeader& header) const {
+        std::vector<IndexTermRecord> records;
+        std::string strings;
+        uint64_t postings_size = 0;
+        for(const Segment& segment : segments) {
+            for(const Term& term : segment.terms) {
+                records.push_back({postings_size + term.offset,
+                                   static_cast<uint32_t>(strings.size()),
+                                   static_cast<uint32_t>(term.word.size()),
+                                   term.doc_count, term.bytes});
+                strings += term.word;
+            }
+            postings_size += segment.postings.size();
+        }
+
+        std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+        header.version = INDEX_VERSION;
+        header.normalize = static_cast<uint32_t>(activeNormalizeMode());
+        header.num_terms = static_cast<uint32_t>(records.size());
+        header.num_files = num_files;
+        header.terms_offset = sizeof(IndexHeader);
+        header.strings_offset = header.terms_offset + records.size() * sizeof(IndexTermRecord);
+        header.postings_offset = header.strings_offset + strings.size();
+        header.file_size = header.postings_offset + postings_size;
+
+        bool ok = writeAll(fd, &header, sizeof(header)) &&
+                  writeAll(fd, records.data(), records.size() * sizeof(IndexTermRecord)) &&
+                  writeAll(fd, strings.data(), strings.size());
+        for(const Segment& segment : segments) {
+            ok = ok && writeAll(fd, segment.postings.data(), segment.postings.size());
+        }
+        return ok;
+    }
+
+    bool writePositions(const std::string& path, const IndexHeader& index) const {
+        std::vector<PositionsTermRecord> records;
+        records.reserve(index.num_terms);
+        uint64_t data_size = 0;
+        for(const Segment& segment : segments) {
+            for(const Term& term : segment.terms) {
+                records.push_back({data_size + term.positions_offset, term.positions_bytes});
+            }
+            data_size += segment.positions.size();
+        }
+
+        PositionsHeader header{};
+        std::memcpy(header.magic, POSITIONS_MAGIC, sizeof(header.magic));
+        header.version = POSITIONS_VERSION;
+        header.num_terms = index.num_terms;
+        header.index_size = index.file_size;
+        header.data_offset = sizeof(PositionsHeader) + records.size() * sizeof(PositionsTermRecord);
+        header.file_size = header.data_offset + data_size;
+
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) {
+            return false;
+        }
+        bool ok = writeAll(fd, &header, sizeof(header)) &&
+                  writeAll(fd, records.data(), records.size() * sizeof(PositionsTermRecord));
+        for(const Segment& segment : segments) {
+            ok = ok && writeAll(fd, segment.positions.data(), segment.positions.size());
+        }
+        ok = ::close(fd) == 0 && ok;
+        return ok;
+    }
+};
+
+// Indexul binar incarcat prin mmap: nu se parseaza nimic la deschidere,
+// termenii se cauta binar direct in tabela mapata, iar postarile se
+// decodifica la cerere
+class IndexFile {
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    const IndexHeader* header = nullptr;
+    const IndexTermRecord* records = nullptr;
+    const char* strings = nullptr;
+    const uint8_t* postings = nullptr;
+    PositionFile positions; // <index>.pos, daca exista
+
+    void unmap() {
+        if(base != nullptr) {
+            munmap(const_cast<uint8_t*>(base), length);
+        }
+        base = nullptr;
+        length = 0;
+        header = nullptr;
+    }
+
+    // verifica ca sectiunile si fiecare termen raman in interiorul fisierului
+    bool validate() const {
+        if(length < sizeof(IndexHeader) ||
+           std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+           header->version != INDEX_VERSION || header->file_size != length ||
+           header->normalize > static_cast<uint32_t>(NormalizeMode::Fold)) {
+            return false;
+        }
+        uint64_t terms_end = header->terms_offset + uint64_t(header->num_terms) * sizeof(IndexTermRecord);
+        if(header->terms_offset != sizeof(IndexHeader) || terms_end != header->strings_offset ||
+           header->strings_offset > header->postings_offset || header->postings_offset > length) {
+            return false;
+        }
+        uint64_t strings_size = header->postings_offset - header->strings_offset;
+        uint64_t postings_size = length - header->postings_offset;
+        for(uint32_t i = 0; i < header->num_terms; i++) {
+            const IndexTermRecord& r = records[i];
+            if(uint64_t(r.string_offset) + r.string_length > strings_size ||
+               r.postings_offset + r.postings_bytes > postings_size) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    IndexFile() = default;
+    IndexFile(const IndexFile&) = delete;
+    IndexFile& operator=(const IndexFile&) = delete;
+
+    ~IndexFile() {
+        unmap();
+    }
+
+    // mapeaza fisierul; false daca nu exista sau nu e un index valid
+    bool open(const std::string& path) {
+        unmap();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return false;
+        }
+        bool ok = open(fd);
+        ::close(fd);
+        if(ok) {
+            positions.open(positionsPath(path), header->file_size, header->num_terms);
+        }
+        return ok;
+    }
+
+    // mapeaza un index dintr-un descriptor deschis (de exemplu un memfd),
+    // fara pozitii; descriptorul ramane deschis
+    bool open(int fd) {
+        unmap();
+        struct stat st{};
+        void* mapped = MAP_FAILED;
+        if(fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(IndexHeader))) {
+            mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        if(mapped == MAP_FAILED) {
+            return false;
+        }
+        base = static_cast<const uint8_t*>(mapped);
+        length = st.st_size;
+        header = reinterpret_cast<const IndexHeader*>(base);
+        records = reinterpret_cast<const IndexTermRecord*>(base + sizeof(IndexHeader));
+        if(!validate()) {
+            unmap();
+            return false;
+        }
+        strings = reinterpret_cast<const char*>(base + header->strings_offset);
+        postings = base + header->postings_offset;
+        return true;
+    }
+
+    bool isOpen() const {
+        return header != nullptr;
+    }
+
+    uint32_t size() const {
+        return header->num_terms;
+    }
+
+    // cel mai mare file_id din index
+    uint32_t numFiles() const {
+        return header->num_files;
+    }
+
+    // normalizarea termenilor; interogarile trebuie normalizate la fel
+    NormalizeMode normalizeMode() const {
+        return static_cast<NormalizeMode>(header->normalize);
+    }
+
+    std::string_view term(uint32_t index) const {
+        return std::string_view(strings + records[index].string_offset, records[index].string_length);
+    }
+
+    uint32_t docCount(uint32_t index) const {
+        return records[index].doc_count;
+    }
+
+    // pozitia primului termen >= word (cautare binara)
+    uint32_t lowerBound(std::string_view word) const {
+        uint32_t low = 0, high = header->num_terms;
+        while(low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            if(term(mid) < word) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    // pozitia termenului in tabela, sau -1
+    int64_t find(std::string_view word) const {
+        uint32_t index = lowerBound(word);
+        return index < header->num_terms && term(index) == word ? int64_t(index) : -1;
+    }
+
+    // parcurge crescator id-urile fisierelor termenului
+    template<class F>
+    void forEachPosting(uint32_t index, F&& callback) const {
+        const IndexTermRecord& r = records[index];
+        const uint8_t* p = postings + r.postings_offset;
+        const uint8_t* end = p + r.postings_bytes;
+        uint32_t id = 0;
+        while(p < end) {
+            id += readVarint(p, end);
+            callback(id);
+        }
+    }
+
+    // postarile codificate ale termenului: offset-ul in sectiunea postarilor
+    // (vezi postingsData) si numarul de octeti
+    uint64_t postingsOffset(uint32_t index) const {
+        return records[index].postings_offset;
+    }
+
+    uint32_t postingsBytes(uint32_t index) const {
+        return records[index].postings_bytes;
+    }
+
+    const uint8_t* postingsData() const {
+        return postings;
+    }
+
+    // postarile termenului, decodificate intr-un vector
+    void postingsOf(uint32_t index, std::vector<uint32_t>& out) const {
+        out.clear();
+        out.reserve(records[index].doc_count);
+        forEachPosting(index, [&out](uint32_t id) { out.push_back(id); });
+    }
+
+    // indexul are pozitiile termenilor (construit cu --positions)
+    bool hasPositions() const {
+        return positions.isOpen();
+    }
+
+    // pozitiile termenului in fiecare fisier din postari, in aceeasi ordine
+    // (vezi PositionFile::decode); doar daca hasPositions()
+    void positionsOf(uint32_t index, std::vector<uint32_t>& bounds, std::vector<uint32_t>& out) const {
+        positions.decode(index, records[index].doc_count, bounds, out);
+    }
+};
+
+inline void IndexBuilder::addIndex(const IndexFile& part) {
+    for(uint32_t first = 0; first < part.size();) {
+        // termenii unei litere sunt consecutivi, iar postarile lor formeaza
+        // o zona continua: segmentul literei
+        char letter = letterOf(part.term(first));
+        uint32_t last = first;
+        uint64_t low = UINT64_MAX, high = 0;
+        for(; last < part.size() && letterOf(part.term(last)) == letter; last++) {
+            low = std::min(low, part.postingsOffset(last));
+            high = std::max(high, part.postingsOffset(last) + part.postingsBytes(last));
+        }
+        Segment& segment = segments[letter - 'a'];
+        uint64_t base = segment.postings.size();
+        segment.postings.insert(segment.postings.end(), part.postingsData() + low, part.postingsData() + high);
+        for(uint32_t t = first; t < last; t++) {
+            segment.terms.push_back({part.term(t), base + part.postingsOffset(t) - low, part.docCount(t),
+                                     part.postingsBytes(t), 0, 0});
+        }
+        first = last;
+    }
+}
+
+#endif // INDEX_FILE_H
@@ -0,0 +1,132 @@
+#ifndef INPUT_READER_H
+#define INPUT_READER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Sub acest prag fisierele se citesc cu read(), mmap nu merita costul
+const size_t MMAP_THRESHOLD = 64 * 1024;
+// dimensiunea unui bloc citit cu read() cand nu se cunoaste marimea (pipe-uri)
+const size_t READ_CHUNK_SIZE = 64 * 1024;
+
+// Fisier de intrare mapat in memorie (sau citit in buffer, ca fallback)
+// Continutul se expune ca std::string_view, fara copii suplimentare
+class MappedFile {
+private:
+    const char* mapped = nullptr; // zona mapata cu mmap (daca exista)
+    size_t mapped_size = 0; // dimensiunea zonei mapate
+    std::vector<char> buffer; // buffer-ul folosit de fallback-ul cu read()
+    bool opened = false;
+
+    // citeste tot continutul descriptorului in buffer (merge si pentru pipe-uri)
+    bool readAll(int fd, size_t size_hint) {
+        // +1 ca sa se detecteze EOF fara o realocare pentru fisierele regulate
+        buffer.resize(size_hint > 0 ? size_hint + 1 : READ_CHUNK_SIZE);
+        size_t used = 0;
+        for(;;) {
+            if(used == buffer.size()) {
+                buffer.resize(buffer.size() * 2);
+            }
+            ssize_t n = ::read(fd, buffer.data() + used, buffer.size() - used);
+            if(n < 0) {
+                return false;
+            }
+            if(n == 0) {
+                break;
+            }
+            used += static_cast<size_t>(n);
+        }
+        buffer.resize(used);
+        return true;
+    }
+
+public:
+    explicit MappedFile(const std::string& file_name) {
+        int fd = ::open(file_name.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return;
+        }
+
+        struct stat st{};
+        bool regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+        if(regular && static_cast<size_t>(st.st_size) >= MMAP_THRESHOLD) {
+            void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(addr != MAP_FAILED) {
+                // fisierul e parcurs o singura data, de la inceput la sfarsit
+                madvise(addr, st.st_size, MADV_SEQUENTIAL);
+                mapped = static_cast<const char*>(addr);
+                mapped_size = st.st_size;
+                opened = true;
+            }
+        }
+
+        // fallback: fisiere mici, pipe-uri sau mmap esuat
+        if(!opened) {
+            size_t size_hint = regular ? static_cast<size_t>(st.st_size) : 0;
+            opened = readAll(fd, size_hint);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if(mapped != nullptr) {
+            munmap(const_cast<char*>(mapped), mapped_size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const {
+        return opened;
+    }
+
+    std::string_view data() const {
+        if(mapped != nullptr) {
+            return std::string_view(mapped, mapped_size);
+        }
+        return std::string_view(buffer.data(), buffer.size());
+    }
+};
+
+// Separatorii folositi de operator>> (isspace in locale-ul "C")
+inline bool isTokenSeparator(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Parcurge token-urile separate prin spatii direct peste textul dat
+// si apeleaza callback-ul cu un string_view pentru fiecare token
+template<class F>
+void forEachToken(std::string_view text, F&& callback) {
+    size_t pos = 0;
+    const size_t len = text.size();
+    while(pos < len) {
+        while(pos < len && isTokenSeparator(text[pos])) pos++;
+        size_t start = pos;
+        while(pos < len && !isTokenSeparator(text[pos])) pos++;
+        if(pos > start) {
+            callback(text.substr(start, pos - start));
+        }
+    }
+}
+
+// Cea mai mica pozitie >= pos la care poate incepe un token (inceputul
+// textului, sfarsitul lui sau un octet precedat de un separator).
+// O bucata [chunkBoundary(begin), chunkBoundary(end)) contine exact
+// token-urile care incep in [begin, end), fara sa taie vreun cuvant.
+inline size_t chunkBoundary(std::string_view text, size_t pos) {
+    if(pos >= text.size()) {
+        return text.size();
+    }
+    while(pos > 0 && pos < text.size() && !isTokenSeparator(text[pos - 1])) {
+        pos++;
+    }
+    return pos;
+}
+
+#endif // INPUT_READER_H
@@ -3,7 +3,6 @@
 #include <vector>
 #include <string>
 #include <map>
-#include <set>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -13,24 +12,84 @@
 #include <filesystem>
 #include <atomic>
 #include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <iterator>
 #include <functional>
-#include <future>
-#include <queue>
-#include <locale>
 
+#include "input_reader.h"
+#include "work_stealing.h"
+#include "tokenizer.h"
+#include "term_dictionary.h"
+#include "postings.h"
+#include "partial_index.h"
+#include "concurrent_hash_index.h"
+#include "reducer_data.h"
+#include "stream_shuffle.h"
+#include "partitioner.h"
+#include "output_writer.h"
+#include "index_file.h"
+#include "incremental.h"
+#include "query_server.h"
+#include "run_stats.h"
+#include "spill.h"
+#include "placement.h"
+#include "prefetch.h"
+#include "compressed_input.h"
+#include "process_shuffle.h"
 
-const int ALPHABET_SIZE = 26;
+
+const int ALPHABET_SIZE = LETTER_SLOTS;
+// fisierele mai mari de atat se impart intre mai multi mapperi
+const uint64_t DEFAULT_CHUNK_SIZE = 16 * 1024 * 1024;
+
+// modul in care ajung cuvintele de la mapperi la reduceri
+enum class ShuffleMode {
+    Local, // fiecare mapper are un index partial propriu, interclasat la reduce
+    Shared, // mapperii scriu direct in ReducerData, sub mutex
+    Stream, // mapperii trimit loturi prin cozi lock-free reducerilor care ruleaza deja
+    Process // mapperii si reducerii sunt procese (fork), run-urile trec prin memfd
+};
+
+// impartirea cuvintelor intre reduceri
+enum class PartitionMode {
+    Letter, // intervale egale de litere (impartirea initiala)
+    Load // intervale de prefixe echilibrate dupa un esantion din fisiere
+};
+
+// rezultatele produse de reduceri
+enum class OutputFormat {
+    Text, // cate un fisier text pentru fiecare litera
+    Binary, // doar indexul binar
+    Both
+};
 
 // structura ce retine argumentele din input
 struct InputArgs {
     int num_mappers; // numarul de thread-uri mapper
     int num_reducers; // numarul de thread-uri reducer
     std::string input_file; // numele fisierului de input
+    ShuffleMode shuffle = ShuffleMode::Local; // --shuffle=local|shared|stream
+    IndexBackend backend = IndexBackend::Map; // --backend=map|hash
+    uint64_t chunk_size = DEFAULT_CHUNK_SIZE; // --chunk-size=<KB>, 0 = fara impartire
+    PartitionMode partition = PartitionMode::Load; // --partition=letter|load
+    OutputFormat output = OutputFormat::Text; // --output=text|binary|both
+    std::string index_file = "index.bin"; // --index-file=<cale>
+    std::string incremental_dir; // --incremental=<director>, gol = indexare completa
+    std::string stats_file; // --stats[=<fisier>], gol = fara raport
+    uint64_t memory_budget = 0; // --memory-budget=<MB>, 0 = fara limita
+    std::string spill_dir; // --spill-dir=<director>, gol = $TMPDIR sau /tmp
+    AffinityPolicy affinity = AffinityPolicy::None; // --affinity=none|cores|nodes|auto
+    int prefetch = 0; // --prefetch=<fisiere>, 0 = fara citire in avans
+    PrefetchEngine prefetch_io = PrefetchEngine::Auto; // --prefetch-io=auto|uring|pread
+    NormalizeMode normalize = NormalizeMode::Ascii; // --normalize=ascii|utf8|fold
+    bool positions = false; // --positions: tf si pozitiile termenilor, in <index>.pos
 };
 
 // Functie pentru parsarea argumentelor din input
+// ./tema1 <numar_mapperi> <numar_reduceri> <fisier_intrare> [--optiune=valoare ...]
 InputArgs parseInputArgs(int argc, char** argv) {
-    if (argc != 4) {
+    if (argc < 4) {
         throw std::invalid_argument("Numar invalid de argumente");
     }
 
@@ -43,103 +102,143 @@ InputArgs parseInputArgs(int argc, char** argv) {
     if (args.num_mappers <= 0 || args.num_reducers <= 0) {
         throw std::invalid_argument("Numarul de mappers si reducers trebuie sa fie pozitiv");
     }
-    return args;
-}
 
-// Clasă pentru gestionarea cozii de fișiere cu thread-safety
-class ThreadSafeFilesQueue {
-private:
-    std::vector<std::string> files_name; // vector cu numele fisierelor
-    std::atomic<size_t> current_index{0}; // indexul curent
-    mutable std::mutex mutex; // Declarați mutex-ul ca mutable
+    // optiunile suplimentare, de forma --nume=valoare
+    for(int i = 4; i < argc; i++) {
+        std::string option = argv[i];
+        size_t eq = option.find('=');
+        std::string name = option.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
 
-public:
-    // metoda pentru adaugarea unui nou fisier in coada
-    void addFile(const std::string& filename) {
-        std::lock_guard<std::mutex> lock(mutex);
-        files_name.push_back(filename);
-    }
-    // obtin urmatorul fisier din coada
-    // returneaza false daca nu mai sunt fisiere disponibile
-    bool getNextFile(std::string& file_name, int& file_id) {
-        std::lock_guard<std::mutex> lock(mutex);
-        if(current_index < files_name.size()) {
-            file_id = current_index + 1; // ID începe de la 1
-            file_name = files_name[current_index];
-            current_index++;
-            return true;
+        if(name == "--shuffle") {
+            if(value == "local") {
+                args.shuffle = ShuffleMode::Local;
+            } else if(value == "shared") {
+                args.shuffle = ShuffleMode::Shared;
+            } else if(value == "stream") {
+                args.shuffle = ShuffleMode::Stream;
+            } else if(value == "process") {
+                args.shuffle = ShuffleMode::Process;
+            } else {
+                throw std::invalid_argument("Valoare invalida pentru --shuffle: " + value);
+            }
+        } else if(name == "--backend") {
+            if(value == "map") {
+                args.backend = IndexBackend::Map;
+            } else if(value == "hash") {
+                args.backend = IndexBackend::Hash;
+            } else {
+                throw std::invalid_argument("Valoare invalida pentru --backend: " + value);
+            }
+        } else if(name == "--chunk-size") {
+            long long kb = std::stoll(value);
+            if(kb < 0) {
+                throw std::invalid_argument("Valoare invalida pentru --chunk-size: " + value);
+            }
+            args.chunk_size = static_cast<uint64_t>(kb) * 1024;
+        } else if(name == "--partition") {
+            if(value == "letter") {
+                args.partition = PartitionMode::Letter;
+            } else if(value == "load") {
+                args.partition = PartitionMode::Load;
+            } else {
+                throw std::invalid_argument("Valoare invalida pentru --partition: " + value);
+            }
+        } else if(name == "--output") {
+            if(value == "text") {
+                args.output = OutputFormat::Text;
+            } else if(value == "binary") {
+                args.output = OutputFormat::Binary;
+            } else if(value == "both") {
+                args.output = OutputFormat::Both;
+            } else {
+                throw std::invalid_argument("Valoare invalida pentru --output: " + value);
+            }
+        } else if(name == "--index-file") {
+            if(value.empty()) {
+                throw std::invalid_argument("Valoare invalida pentru --index-file: " + value);
+            }
+            args.index_file = value;
+        } else if(name == "--incremental") {
+            if(value.empty()) {
+                throw std::invalid_argument("Valoare invalida pentru --incremental: " + value);
+            }
+            args.incremental_dir = value;
+        } else if(name == "--stats") {
+            args.stats_file = value.empty() ? "stats.json" : value;
+        } else if(name == "--memory-budget") {
+            long long mb = std::stoll(value);
+            if(mb < 0) {
+                throw std::invalid_argument("Valoare invalida pentru --memory-budget: " + value);
+            }
+            args.memory_budget = static_cast<uint64_t>(mb) * 1024 * 1024;
+        } else if(name == "--spill-dir") {
+            if(value.empty()) {
+                throw std::invalid_argument("Valoare invalida pentru --spill-dir: " + value);
+            }
+            args.spill_dir = value;
+        } else if(name == "--affinity") {
+            if(value == "none") {
+                args.affinity = AffinityPolicy::None;
+            } else if(value == "cores") {
+                args.affinity = AffinityPolicy::Cores;
+            } else if(value == "nodes") {
+                args.affinity = AffinityPolicy::Nodes;
+            } else if(value == "auto") {
+                args.affinity = AffinityPolicy::Auto;
+            } else {
+                throw std::invalid_argument("Valoare invalida pentru --affinity: " + value);
+            }
+        } else if(name == "--prefetch") {
+            args.prefetch = std::stoi(value);
+            if(args.prefetch < 0) {
+                throw std::invalid_argument("Valoare invalida pentru --prefetch: " + value);
+            }
+        } else if(name == "--prefetch-io") {
+            if(value == "auto") {
+                args.prefetch_io = PrefetchEngine::Auto;
+            } else if(value == "uring") {
+                args.prefetch_io = PrefetchEngine::Uring;
+            } else if(value == "pread") {
+                args.prefetch_io = PrefetchEngine::Pread;
+            } else {
+                throw std::invalid_argument("Valoare invalida pentru --prefetch-io: " + value);
+            }
+        } else if(name == "--normalize") {
+            if(value == "ascii") {
+                args.normalize = NormalizeMode::Ascii;
+            } else if(value == "utf8") {
+                args.normalize = NormalizeMode::Utf8;
+            } else if(value == "fold") {
+                args.normalize = NormalizeMode::Fold;
+            } else {
+                throw std::invalid_argument("Valoare invalida pentru --normalize: " + value);
+            }
+        } else if(name == "--positions") {
+            if(eq != std::string::npos) {
+                throw std::invalid_argument("--positions nu primeste o valoare");
+            }
+            args.positions = true;
+        } else {
+            throw std::invalid_argument("Optiune necunoscuta: " + option);
         }
-        return false;
     }
-    
-    size_t size() const {
-        std::lock_guard<std::mutex> lock(mutex);
-        return files_name.size();
+    // doar indexurile partiale ale mapperilor se pot varsa pe disc
+    if(args.memory_budget != 0 && args.shuffle != ShuffleMode::Local) {
+        throw std::invalid_argument("--memory-budget necesita --shuffle=local");
     }
-};
-
-// Pool de thread-uri pentru procesare eficientă
-class ThreadPool {
-private:
-    std::vector<std::thread> workers; // vector de thread-uri worker
-    std::queue<std::function<void()>> tasks; // coada de task-uri
-    std::mutex queue_mutex; // mutex pentru coada de task-uri
-    std::condition_variable condition; // variabila de conditie pentru a sincroniza
-    std::atomic<bool> stop{false}; // flag pentru oprirea pool-ului
-
-public:
-    // constructoe - creeaza si porneste thread-urile worker
-    ThreadPool(size_t threads) {
-        for(size_t i = 0; i < threads; ++i)
-            workers.emplace_back([this] {
-                for(;;) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        // asteapta pana cand exista un task sau pool-ul este oprit
-                        this->condition.wait(lock, [this]{ 
-                            return this->stop || !this->tasks.empty(); 
-                        });
-                        if(this->stop && this->tasks.empty())
-                            return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-                    task();
-                }
-            });
+    // pozitiile se scriu doar langa indexul binar al unei indexari complete
+    if(args.positions && args.output == OutputFormat::Text) {
+        throw std::invalid_argument("--positions necesita --output=binary|both");
     }
-    // adauga un task in pool si returneaza un future pentru rezultat
-    template<class F>
-    auto enqueue(F&& f) -> std::future<typename std::result_of<F()>::type> {
-        using return_type = typename std::result_of<F()>::type;
-        
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::forward<F>(f)
-        );
-        
-        std::future<return_type> res = task->get_future();
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            if(stop)
-                throw std::runtime_error("Încearcă să adaugi task după oprirea thread pool-ului");
-            
-            tasks.emplace([task](){ (*task)(); });
-        }
-        condition.notify_one();
-        return res;
+    if(args.positions && (!args.incremental_dir.empty() || args.memory_budget != 0)) {
+        throw std::invalid_argument("--positions nu se poate folosi cu --incremental sau --memory-budget");
     }
-    // destructor - opreste toate thread-urile si asteapta finalizarea lor
-    ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex);
-            stop = true;
-        }
-        condition.notify_all();
-        for(std::thread &worker: workers)
-            worker.join();
+    if(args.positions && args.shuffle == ShuffleMode::Process) {
+        throw std::invalid_argument("--positions nu se poate folosi cu --shuffle=process");
     }
-};
+    return args;
+}
 
 // Clasa pentru controlul procesului de mapping
 class MappingControl {
@@ -163,116 +262,169 @@ public:
     }
 };
 
-// Clasa pentru gestionarea datelor reducerilor
-class ReducerData {
-private:
-    std::map<std::string, std::set<int>> word_map;
-    std::mutex mutex;
+// Functie pentru gestionarea erorilor de thread
+void handleThreadError(const std::string& errorMessage) {
+    std::cerr << "Eroare la thread: " << errorMessage << std::endl;
+    std::terminate();
+}
 
-public:
-    void addWord(const std::string& word, int file_id) {
-        std::lock_guard<std::mutex> lock(mutex);
-        word_map[word].insert(file_id);
-    }
 
-    std::vector<std::pair<std::string, std::set<int>>> getWordsForLetter(char letter) {
-        std::lock_guard<std::mutex> lock(mutex);
-        std::vector<std::pair<std::string, std::set<int>>> result;
-        
-        for(const auto& entry : word_map) {
-            if(entry.first[0] == letter) {
-                result.push_back(entry);
-            }
-        }
-        return result;
-    }
+// Destinatia termenilor emisi de un mapper; exact unul dintre campuri
+// este folosit, in functie de --shuffle
+struct MapperSink {
+    std::vector<std::unique_ptr<ReducerData>>* reducers = nullptr; // shared
+    PartialIndex* local = nullptr; // local
+    StreamProducer* stream = nullptr; // stream
+    const SpillDirectory* spill = nullptr; // local, cu --memory-budget
+    PositionCollector* positions = nullptr; // oricare, cu --positions
 };
 
-// Functie pentru normalizarea cuvintelor cu suport internațional
-std::string normalizeWord(const std::string& word) {
-    std::string normalized;
-    std::locale loc;
-    for(char c : word) {
-        if(std::isalpha(c, loc)) {
-            normalized += std::tolower(c, loc);
+// Trimite termenii distincti ai unui fisier catre reducerii responsabili
+void emitFileTerms(const std::vector<std::pair<TermId, PrefixCell>>& file_terms,
+                   int file_id,
+                   const Partitioner& partitioner,
+                   MapperSink& sink) {
+    // Distribuie cuvintele catre Reduceri
+    for(const auto& [term, cell] : file_terms) {
+        // Reducer-ul responsabil se ia din tabelul partitionerului
+        int reducer_index = partitioner.reducerFor(cell);
+
+        // Adauga cuvantul la Reducer-ul corespunzator
+        if(sink.local != nullptr) {
+            sink.local->add(reducer_index, term, file_id);
+        } else if(sink.stream != nullptr) {
+            sink.stream->emit(reducer_index, term, file_id);
+        } else {
+            (*sink.reducers)[reducer_index]->addWord(term, file_id);
         }
     }
-    return normalized;
 }
 
-// Comparator pentru sortarea cuvintelor 
-bool compareWords(const std::pair<std::string, std::set<int>>& a, 
-                  const std::pair<std::string, std::set<int>>& b) {
-    if(a.second.size() != b.second.size()) {
-        return a.second.size() > b.second.size(); // Descrescator după numarul de fisiere
-    }
-    return a.first < b.first; // Alfabetic
-}
+// Functia Mapper
+// cuvintele se transforma in TermId-uri prin dictionarul global si se trimit
+// catre sink: indexul partial al mapper-ului (fara lock-uri), cozile de
+// shuffle in flux sau direct ReducerData. Fisierele vin din input (citite
+// in avans cu --prefetch). Cu --positions, pozitia fiecarui cuvant se
+// retine ca indicele termenului lui in file_terms si se preda colectorului
+// dupa fisier. stats e nul fara --stats.
+void mapperFunction(MapperInput& input,
+                    int worker,
+                    const Partitioner& partitioner,
+                    TermDictionary& dict,
+                    MapperSink sink,
+                    stats::MapperStats* stats) {
+    MapTask task;
+    TermCache cache(dict);
+    // termenii distincti ai fisierului curent, cu celula de prefix a fiecaruia
+    std::vector<std::pair<TermId, PrefixCell>> file_terms;
+    // pentru fiecare pozitie din fisier, indicele termenului in file_terms
+    std::vector<uint32_t> file_slots;
+    // buffer-ul refolosit pentru blocurile fisierelor comprimate
+    std::vector<char> decompressed;
+    // preiau fisierele de la planificator si atribui cate un reducer
+    while(input.next(task)) {
+        const std::string& file_name = task.file_name;
+        const int file_id = task.file_id;
+        try {
+            stats::Clock::time_point start;
+            if(stats != nullptr) start = stats::Clock::now();
 
+            file_terms.clear();
+            file_slots.clear();
+            std::string_view text;
+            if(!input.open(text)) {
+                std::cerr << "Eroare la deschiderea fișierului: " << file_name << std::endl;
+                // bucata se raporteaza oricum, ca fisierul sa poata fi emis
+                if(task.chunked != nullptr && task.chunked->addPart(file_terms)) {
+                    emitFileTerms(file_terms, file_id, partitioner, sink);
+                }
+                continue;
+            }
 
+            // pentru o bucata dintr-un fisier mare se proceseaza doar
+            // token-urile care incep in intervalul ei
+            if(task.chunked != nullptr) {
+                size_t begin = chunkBoundary(text, task.begin);
+                size_t end = chunkBoundary(text, task.end);
+                text = text.substr(begin, end - begin);
+            }
+            stats::Clock::time_point tokenize_start;
+            if(stats != nullptr) {
+                tokenize_start = stats::Clock::now();
+                stats->open_seconds += std::chrono::duration<double>(tokenize_start - start).count();
+            }
 
-// Functie pentru gestionarea erorilor de thread
-void handleThreadError(const std::string& errorMessage) {
-    std::cerr << "Eroare la thread: " << errorMessage << std::endl;
-    std::terminate();
-}
+            // determina termenii unici din fisier, direct peste octetii mapati;
+            // cache-ul retine ultimul fisier al fiecarui termen, deci un termen
+            // se adauga o singura data per fisier, fara alocari
+            uint64_t tokens = 0;
+            auto addWord = [&](std::string_view normalized) {
+                tokens++;
+                TermCache::Entry& entry = cache.lookup(normalized);
+                if(entry.last_file != file_id) {
+                    entry.last_file = file_id;
+                    entry.file_slot = static_cast<uint32_t>(file_terms.size());
+                    file_terms.emplace_back(entry.id, prefixCell(entry.word));
+                }
+                if(sink.positions != nullptr) {
+                    file_slots.push_back(entry.file_slot);
+                }
+            };
+            // fisierele comprimate (nu se impart niciodata in bucati) se
+            // decomprima in flux, bloc cu bloc, direct in tokenizator
+            Compression format = detectCompression(text);
+            uint64_t text_bytes = text.size();
+            if(format == Compression::None) {
+                forEachNormalizedWord(text, addWord);
+            } else {
+                NormalizedWordStream words;
+                text_bytes = 0;
+                bool ok = forEachDecompressedBlock(text, format, decompressed, [&](std::string_view block) {
+                    text_bytes += block.size();
+                    words.feed(block, addWord);
+                    return true;
+                });
+                words.finish(addWord);
+                if(!ok) {
+                    std::cerr << "Eroare la decomprimarea fișierului: " << file_name << std::endl;
+                }
+            }
 
+            stats::Clock::time_point emit_start;
+            if(stats != nullptr) {
+                emit_start = stats::Clock::now();
+                stats->tokenize_seconds += std::chrono::duration<double>(emit_start - tokenize_start).count();
+                stats->files++;
+                stats->bytes += text_bytes;
+                stats->tokens += tokens;
+            }
 
-// Functia Mapper
-void mapperFunction(ThreadSafeFilesQueue& queue, 
-                    std::vector<std::unique_ptr<ReducerData>>& reducers, 
-                    int num_reducers) {
-    std::string file_name;
-    int file_id;
-    // preiau din coada de fisiere si atribui cate un reducer
-    while(queue.getNextFile(file_name, file_id)) {
-        try {
-            
-            std::ifstream file(file_name);
-            if(!file.is_open()) {
-                std::cerr << "Eroare la deschiderea fișierului: " << file_name << std::endl;
+            // bucatile unui fisier isi reunesc termenii; doar ultima bucata
+            // terminata emite postarile, o singura data pentru tot fisierul
+            if(task.chunked != nullptr && !task.chunked->addPart(file_terms)) {
                 continue;
             }
 
-            // determina cuvintele unice din fisier
-            std::set<std::string> unique_words;
-            std::string word;
-            while(file >> word) {
-                std::string normalized = normalizeWord(word);
-                if(normalized.empty()) continue;
-                unique_words.insert(normalized);
-            }
-            file.close();
-           
-          
-
-            // Distribuie cuvintele catre Reduceri
-            for(const auto& w : unique_words) {
-                if(w.empty()) continue;
-
-                char first_letter = w[0];
-                if(first_letter < 'a' || first_letter > 'z') continue;
-
-                // Determină Reducer-ul responsabil pentru această literă
-                int letter_pos = first_letter - 'a';
-                int letters_per_reducer = ALPHABET_SIZE / num_reducers;
-                int extra_letters = ALPHABET_SIZE % num_reducers;
-                
-                int reducer_index = 0;
-                int cumulative_letters = 0;
-                for(int i = 0; i < num_reducers; i++) {
-                    int current_reducer_letters = letters_per_reducer + (i < extra_letters ? 1 : 0);
-                    if(letter_pos < cumulative_letters + current_reducer_letters) {
-                        reducer_index = i;
-                        break;
-                    }
-                    cumulative_letters += current_reducer_letters;
-                }
+            emitFileTerms(file_terms, file_id, partitioner, sink);
+            if(sink.positions != nullptr) {
+                sink.positions->addFile(file_id, file_terms, file_slots);
+            }
+            if(stats != nullptr) {
+                stats->terms += file_terms.size();
+                stats->emit_seconds += stats::secondsSince(emit_start);
+            }
 
-                // Adauga cuvantul la Reducer-ul corespunzator
-                reducers[reducer_index]->addWord(w, file_id);
+            // peste buget, indexul partial se varsa pe disc intre fisiere
+            if(sink.local != nullptr && sink.local->overBudget()) {
+                uint64_t bytes = 0;
+                if(!sink.local->spill(*sink.spill, "m" + std::to_string(worker), bytes)) {
+                    throw std::runtime_error("nu s-au putut scrie run-urile temporare");
+                }
+                if(stats != nullptr) {
+                    stats->spills++;
+                    stats->spill_bytes += bytes;
+                }
             }
-            
         }
         catch(const std::exception& e) {
             handleThreadError("Eroare în mapper: " + std::string(e.what()));
@@ -280,59 +432,946 @@ void mapperFunction(ThreadSafeFilesQueue& queue,
       
        
     }
+
+    // indexul partial se sorteaza tot in thread-ul mapper-ului
+    if(sink.local != nullptr) {
+        sink.local->seal();
+    }
+    // loturile incomplete pleaca si ele, apoi reducerii afla ca am terminat
+    if(sink.stream != nullptr) {
+        sink.stream->finish();
+    }
+    if(stats != nullptr) {
+        stats->collectLocks();
+        if(sink.positions != nullptr) {
+            stats->position_bytes = sink.positions->allocatedBytes();
+        }
+    }
+}
+
+// Fisierul unei litere impartite intre mai multi reduceri: fiecare reducer
+// isi sorteaza bucata, iar ultimul care termina interclaseaza bucatile
+// sortate si scrie fisierul
+template<class Entry>
+class LetterOutput {
+private:
+    std::mutex mutex;
+    int pending = 1; // bucatile inca nepredate
+    std::vector<Entry> words; // bucatile predate, concatenate
+    std::vector<size_t> bounds; // inceputul fiecarei bucati in words
+
+public:
+    void expectParts(int parts) {
+        pending = parts;
+    }
+
+    // preda bucata sortata a unui reducer; intoarce true pentru ultima,
+    // caz in care part primeste toate cuvintele literei, sortate
+    bool addPart(std::vector<Entry>& part, const TermDictionary& dict) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(--pending > 0) {
+            bounds.push_back(words.size());
+            std::move(part.begin(), part.end(), std::back_inserter(words));
+            return false;
+        }
+        if(words.empty()) {
+            return true; // singura bucata (cazul obisnuit)
+        }
+        bounds.push_back(words.size());
+        std::move(part.begin(), part.end(), std::back_inserter(words));
+        auto less = [&dict](const Entry& a, const Entry& b) {
+            return compareWords(a, b, dict);
+        };
+        bounds.push_back(words.size());
+        for(size_t i = 1; i + 1 < bounds.size(); i++) {
+            std::inplace_merge(words.begin(), words.begin() + bounds[i],
+                               words.begin() + bounds[i + 1], less);
+        }
+        part.swap(words);
+        words = {};
+        return true;
+    }
+};
+
+// Iesirea comuna a reducerilor: bucatile fiecarei litere si coada
+// literelor complete, gata de scris. Entry este IndexEntry, sau SpilledKey
+// cand postarile au fost varsate pe disc (--memory-budget).
+template<class Entry = IndexEntry>
+struct ReduceOutput {
+    std::unique_ptr<LetterOutput<Entry>[]> letters;
+    LetterWriteQueue<Entry> queue;
+    bool text; // fisierele text ale literelor
+    std::unique_ptr<IndexBuilder> index; // indexul binar, daca e cerut
+    PositionStore* positions = nullptr; // cu --positions
+
+    // num_letters: literele scrise prin aceasta iesire (toate, sau doar ale
+    // unui proces reducer, cu --shuffle=process)
+    ReduceOutput(const Partitioner& partitioner, OutputFormat format, int num_letters = ALPHABET_SIZE)
+        : letters(new LetterOutput<Entry>[ALPHABET_SIZE]), queue(num_letters),
+          text(format != OutputFormat::Binary) {
+        if(format != OutputFormat::Text) {
+            index = std::make_unique<IndexBuilder>();
+        }
+        for(int l = 0; l < ALPHABET_SIZE; l++) {
+            letters[l].expectParts(partitioner.reducersForLetter('a' + l));
+        }
+    }
+};
+
+// Sorteaza bucata reducerului dintr-o litera si, daca e ultima, pune
+// litera in coada de scriere
+template<class Entry>
+void finishLetter(char letter, std::vector<Entry>& words,
+                  ReduceOutput<Entry>& output, const TermDictionary& dict) {
+    sortWords(words, dict);
+    if(output.letters[letter - 'a'].addPart(words, dict)) {
+        output.queue.submit(letter, std::move(words));
+    }
+}
+
+// Grupeaza termenii partitiei dupa prima litera (luata din dictionar),
+// termina fiecare litera a reducerului, apoi ajuta la scrierea fisierelor.
+// Cu --positions, pozitiile partitiei se sorteaza inainte ca literele ei sa
+// poata ajunge in coada de scriere.
+void writePartition(int reducer,
+                    const std::vector<char>& letters,
+                    std::vector<IndexEntry>& entries,
+                    ReduceOutput<>& output,
+                    const TermDictionary& dict,
+                    stats::ReducerStats* stats) {
+    stats::Clock::time_point start;
+    if(stats != nullptr) {
+        stats->terms = entries.size();
+        start = stats::Clock::now();
+    }
+    if(output.positions != nullptr) {
+        uint64_t bytes = output.positions->buildTable(reducer);
+        if(stats != nullptr) stats->position_bytes = bytes;
+    }
+    std::vector<std::vector<IndexEntry>> by_letter(ALPHABET_SIZE);
+    for(auto& entry : entries) {
+        by_letter[letterOf(dict.resolve(entry.first)) - 'a'].push_back(std::move(entry));
+    }
+    for(auto letter : letters) {
+        finishLetter(letter, by_letter[letter - 'a'], output, dict);
+    }
+    entries = {};
+    if(stats != nullptr) {
+        stats->sort_seconds = stats::secondsSince(start);
+    }
+    output.queue.work([&](char letter, std::vector<IndexEntry>& words, OutputWriter& writer) {
+        stats::Clock::time_point write_start;
+        uint64_t written = writer.bytesWritten();
+        if(stats != nullptr) write_start = stats::Clock::now();
+        if(output.index != nullptr) {
+            output.index->addLetter(letter, words, dict);
+        }
+        std::string output_filename = letterFileName(letter);
+        if(output.text && !writer.writeFile(output_filename, words, dict)) {
+            std::cerr << "Eroare la crearea fișierului de ieșire: " << output_filename << std::endl;
+        }
+        if(stats != nullptr) {
+            stats->write_seconds += stats::secondsSince(write_start);
+            stats->letters_written++;
+            stats->output_bytes += writer.bytesWritten() - written;
+        }
+    });
+}
+
+// Reducer-ul din modul --shuffle=stream: porneste odata cu mapperii si
+// insereaza loturile pe masura ce sosesc; dupa ultimul lot ramane doar
+// sortarea si scrierea fisierelor
+void streamReducerFunction(int reducer,
+                           std::vector<char> letters,
+                           StreamShuffle& shuffle,
+                           ReduceOutput<>& output,
+                           const TermDictionary& dict,
+                           stats::ReducerStats* stats) {
+    std::unordered_map<TermId, Postings> index;
+    // timpul de shuffle masoara doar inserarea loturilor, nu asteptarea lor
+    stats::Clock::time_point start;
+    shuffle.consume(reducer, [&index, &start, stats](const RecordBatch& batch) {
+        if(stats != nullptr) start = stats::Clock::now();
+        for(const ShuffleRecord& record : batch) {
+            index[record.term].insert(record.file_id);
+        }
+        if(stats != nullptr) stats->shuffle_seconds += stats::secondsSince(start);
+    });
+
+    std::vector<IndexEntry> entries;
+    entries.reserve(index.size());
+    for(auto& entry : index) {
+        entries.emplace_back(entry.first, std::move(entry.second));
+    }
+    index = {};
+    writePartition(reducer, letters, entries, output, dict, stats);
 }
 
 // Funcția Reducer
-void reducerFunction(std::vector<char> letters, 
+// partial_runs contine run-urile sortate ale partitiei acestui reducer,
+// cate unul de la fiecare mapper (gol in modul --shuffle=shared); data
+// exista doar in modul shared
+void reducerFunction(int reducer,
+                     std::vector<char> letters,
                      ReducerData* data, 
-                     MappingControl& control) {
+                     std::vector<std::vector<IndexEntry>*> partial_runs,
+                     ReduceOutput<>& output,
+                     const TermDictionary& dict,
+                     MappingControl& control,
+                     stats::ReducerStats* stats) {
     // Așteapta finalizarea mapping-ului
     control.waitForDone();
 
-    // Pentru fiecare litera atribuita acestui Reducer
+    // faza de shuffle: interclasarea indexurilor partiale ale mapperilor
+    // sau, in modul shared, intrarile adunate direct in ReducerData
+    stats::Clock::time_point start;
+    if(stats != nullptr) start = stats::Clock::now();
+    std::vector<IndexEntry> entries = partial_runs.empty() ? data->takeEntries()
+                                                           : mergeRuns(partial_runs);
+    if(stats != nullptr) stats->shuffle_seconds = stats::secondsSince(start);
+    writePartition(reducer, letters, entries, output, dict, stats);
+}
+
+// Postarile interclasate ale reducerilor, cand mapperii au varsat run-uri pe
+// disc: merged[r] este fisierul reducerului r, mapat dupa interclasare
+struct SpillMerge {
+    const SpillDirectory& dir;
+    std::vector<std::unique_ptr<MappedFile>> merged;
+    std::atomic<bool> failed{false};
+
+    SpillMerge(const SpillDirectory& directory, int num_reducers)
+        : dir(directory), merged(num_reducers) {}
+};
+
+// Reducer-ul pentru indexarea cu buget de memorie, cand s-au varsat run-uri:
+// run-urile partitiei (din memorie si de pe disc) se interclaseaza in flux
+// intr-un fisier temporar, iar in memorie raman doar cheile termenilor.
+// Literele se sorteaza si se scriu ca in reducerFunction, dar postarile se
+// decodifica direct din fisierele interclasate.
+void spillReducerFunction(int reducer,
+                          std::vector<char> letters,
+                          std::vector<std::vector<IndexEntry>*> memory_runs,
+                          std::vector<std::string> run_files,
+                          SpillMerge& spill,
+                          ReduceOutput<SpilledKey>& output,
+                          const TermDictionary& dict,
+                          stats::ReducerStats* stats) {
+    stats::Clock::time_point start;
+    if(stats != nullptr) start = stats::Clock::now();
+    std::vector<std::vector<SpilledKey>> by_letter(ALPHABET_SIZE);
+    std::string path = spill.dir.pathOf("merged-" + std::to_string(reducer));
+    if(!mergeSpilledRuns(memory_runs, run_files, path, reducer, dict, by_letter) ||
+       !(spill.merged[reducer] = std::make_unique<MappedFile>(path))->isOpen()) {
+        std::cerr << "Eroare la interclasarea run-urilor temporare: " << path << std::endl;
+        spill.failed = true;
+        by_letter.assign(ALPHABET_SIZE, {});
+    }
+    if(stats != nullptr) {
+        stats->shuffle_seconds = stats::secondsSince(start);
+        start = stats::Clock::now();
+        for(const auto& keys : by_letter) stats->terms += keys.size();
+    }
+
+    // literele se predau chiar si dupa o eroare, ca ceilalti reduceri sa
+    // nu astepte la nesfarsit
     for(auto letter : letters) {
-        // Colecteaza cuvintele care încep cu aceasta litera
-        auto words = data->getWordsForLetter(letter);
+        finishLetter(letter, by_letter[letter - 'a'], output, dict);
+    }
+    if(stats != nullptr) {
+        stats->sort_seconds = stats::secondsSince(start);
+    }
 
-        if(words.empty()) continue;
+    output.queue.work([&](char letter, std::vector<SpilledKey>& keys, OutputWriter& writer) {
+        stats::Clock::time_point write_start;
+        uint64_t written = writer.bytesWritten();
+        if(stats != nullptr) write_start = stats::Clock::now();
+        if(output.index != nullptr) {
+            output.index->addLetter(letter, keys, dict, [&spill](const SpilledKey& key, auto&& callback) {
+                forEachSpilledId(spill.merged[key.part]->data(), key, callback);
+            });
+        }
+        std::string output_filename = letterFileName(letter);
+        if(output.text) {
+            bool ok = writer.open(output_filename);
+            if(ok) {
+                for(const SpilledKey& key : keys) {
+                    writer.addWord(dict.resolve(key.term), key.files, [&](auto&& emit) {
+                        forEachSpilledId(spill.merged[key.part]->data(), key, emit);
+                    });
+                }
+                ok = writer.close();
+            }
+            if(!ok) {
+                std::cerr << "Eroare la crearea fișierului de ieșire: " << output_filename << std::endl;
+            }
+        }
+        if(stats != nullptr) {
+            stats->write_seconds += stats::secondsSince(write_start);
+            stats->letters_written++;
+            stats->output_bytes += writer.bytesWritten() - written;
+        }
+    });
+}
 
-        // Sortează cuvintele conform cerințelor
-        std::sort(words.begin(), words.end(), compareWords);
 
-        // Creeaza fisierul de ieșire pentru aceasta litera
-        std::string output_filename = std::string(1, letter) + ".txt";
-        std::ofstream output(output_filename);
-        
-        if(!output.is_open()) {
-            std::cerr << "Eroare la crearea fișierului de ieșire: " << output_filename << std::endl;
+// Porneste un thread plasat ca al k-lea din grupul de n (vezi Placement)
+template<class F, class... Args>
+std::thread placedThread(const Placement& placement, int k, int n, int skip, F&& function, Args&&... args) {
+    return std::thread([&placement, k, n, skip](auto&& function, auto&&... args) {
+        placement.pin(k, n, skip);
+        std::invoke(function, std::forward<decltype(args)>(args)...);
+    }, std::forward<F>(function), std::forward<Args>(args)...);
+}
+
+// Faza de map-reduce cu procese (--shuffle=process), cu argumentele lui
+// runMapReduce. Mapperii (procese) isi scriu run-urile in memfd-uri (vezi
+// process_shuffle.h); fiecare litera ajunge la un singur proces reducer,
+// care scrie fisierul ei ca in modul cu threaduri si, pentru indexul binar,
+// un index partial intr-un memfd. Coordonatorul concateneaza indexurile
+// partiale in ordinea reducerilor, adica a literelor.
+bool runProcessMapReduce(const InputArgs& args,
+                         WorkStealingScheduler& scheduler,
+                         const std::vector<std::string>& sample_files,
+                         OutputFormat output,
+                         const std::string& index_file,
+                         uint32_t max_file_id,
+                         stats::RunReport* report) {
+    int num_mappers = args.num_mappers;
+    int num_reducers = args.num_reducers;
+
+    // statisticile proceselor, scrise de copii in memorie partajata
+    SharedArray<stats::MapperStats> mapper_stats(report != nullptr ? num_mappers : 0);
+    SharedArray<stats::ReducerStats> reducer_stats(report != nullptr ? num_reducers : 0);
+    auto phase = stats::Clock::now();
+    auto endPhase = [&](const char* name) {
+        if(report != nullptr) report->addPhase(name, stats::secondsSince(phase));
+        phase = stats::Clock::now();
+    };
+
+    Placement placement(args.affinity);
+
+    // literele nu se impart intre reduceri: fiecare proces scrie litere intregi
+    Partitioner partitioner(num_reducers);
+    if(args.partition == PartitionMode::Load) {
+        partitioner.sample(sample_files);
+        partitioner.assignByLoad(true);
+    } else {
+        partitioner.assignByLetter();
+    }
+    endPhase("partition");
+
+    // run-urile fiecarui mapper si indexurile partiale ale reducerilor
+    std::vector<std::unique_ptr<ShuffleSegment>> runs, partial_indexes;
+    for(int i = 0; i < num_mappers; i++) {
+        runs.push_back(std::make_unique<ShuffleSegment>("tema1-map-" + std::to_string(i)));
+    }
+    for(int r = 0; r < num_reducers && output != OutputFormat::Text; r++) {
+        partial_indexes.push_back(std::make_unique<ShuffleSegment>("tema1-index-" + std::to_string(r)));
+    }
+    for(const auto& segment : runs) {
+        if(!segment->isOpen()) {
+            std::cerr << "Eroare la crearea segmentelor de memorie partajata (memfd)" << std::endl;
+            return false;
+        }
+    }
+    for(const auto& segment : partial_indexes) {
+        if(!segment->isOpen()) {
+            std::cerr << "Eroare la crearea segmentelor de memorie partajata (memfd)" << std::endl;
+            return false;
+        }
+    }
+
+    // fiecare mapper primeste un shard fix (fisierele nu se impart in
+    // bucati: bucatile unui fisier s-ar reuni doar in acelasi proces)
+    scheduler.distribute(num_mappers, 0);
+    scheduler.disableStealing();
+
+    std::vector<pid_t> mappers;
+    for(int i = 0; i < num_mappers; i++) {
+        mappers.push_back(forkWorker([&, i]() {
+            placement.pin(i, num_mappers);
+            TermDictionary dict;
+            PartialIndex partial(num_reducers);
+            MapperSink sink;
+            sink.local = &partial;
+            MapperInput input(scheduler, i, args.prefetch, args.prefetch_io);
+            mapperFunction(input, i, partitioner, dict, sink,
+                           report != nullptr ? &mapper_stats[i] : nullptr);
+            return writeShuffleRuns(*runs[i], partial, dict, num_reducers);
+        }));
+    }
+    bool ok = waitWorkers(mappers, "mapper");
+    endPhase("map");
+    if(!ok) {
+        return false;
+    }
+
+    std::vector<pid_t> reducers;
+    for(int r = 0; r < num_reducers; r++) {
+        reducers.push_back(forkWorker([&, r]() {
+            placement.pin(r, num_reducers);
+            stats::ReducerStats* stats = report != nullptr ? &reducer_stats[r] : nullptr;
+            stats::Clock::time_point start;
+            if(stats != nullptr) start = stats::Clock::now();
+
+            // faza de shuffle: termenii partitiei din toate segmentele
+            TermDictionary dict;
+            std::unordered_map<TermId, Postings> index;
+            std::vector<uint32_t> ids;
+            for(auto& segment : runs) {
+                bool valid = forEachShuffledTerm(segment->map(), r, num_reducers, ids,
+                                                 [&](std::string_view word, const std::vector<uint32_t>& files) {
+                    Postings& postings = index[dict.intern(word, hashWord(word))];
+                    for(uint32_t id : files) postings.insert(static_cast<int>(id));
+                });
+                if(!valid) {
+                    std::cerr << "Segment de shuffle invalid" << std::endl;
+                    return false;
+                }
+            }
+            std::vector<IndexEntry> entries;
+            entries.reserve(index.size());
+            for(auto& entry : index) {
+                entries.emplace_back(entry.first, std::move(entry.second));
+            }
+            index = {};
+            if(stats != nullptr) stats->shuffle_seconds = stats::secondsSince(start);
+
+            const std::vector<char>& letters = partitioner.letters(r);
+            ReduceOutput<> reduce_output(partitioner, output, static_cast<int>(letters.size()));
+            writePartition(r, letters, entries, reduce_output, dict, stats);
+            return reduce_output.index == nullptr ||
+                   reduce_output.index->write(partial_indexes[r]->descriptor(), max_file_id);
+        }));
+    }
+    ok = waitWorkers(reducers, "reducer");
+    endPhase("reduce");
+    if(report != nullptr) {
+        for(int i = 0; i < num_mappers; i++) report->mappers.push_back(mapper_stats[i]);
+        for(int r = 0; r < num_reducers; r++) report->reducers.push_back(reducer_stats[r]);
+    }
+    if(!ok || output == OutputFormat::Text) {
+        return ok;
+    }
+
+    // indexul binar: fiecare litera vine, intreaga, dintr-un singur index
+    // partial; indexurile partiale raman mapate pana la scriere
+    IndexBuilder index;
+    std::vector<std::unique_ptr<IndexFile>> parts;
+    for(const auto& segment : partial_indexes) {
+        parts.push_back(std::make_unique<IndexFile>());
+        if(!parts.back()->open(segment->descriptor())) {
+            std::cerr << "Index partial invalid" << std::endl;
+            return false;
+        }
+        index.addIndex(*parts.back());
+    }
+    if(!index.write(index_file, max_file_id)) {
+        std::cerr << "Eroare la scrierea indexului: " << index_file << std::endl;
+        return false;
+    }
+    endPhase("write_index");
+    return true;
+}
+
+// Faza de map-reduce pentru fisierele din planificator; rezultatul se
+// scrie in formatul dat (fisierele literelor si/sau indexul binar).
+// sample_files sunt fisierele din care partitionerul estimeaza incarcarea.
+// Cu report nenul, fazele si statisticile threadurilor se adauga in raport.
+bool runMapReduce(const InputArgs& args,
+                  WorkStealingScheduler& scheduler,
+                  const std::vector<std::string>& sample_files,
+                  OutputFormat output,
+                  const std::string& index_file,
+                  uint32_t max_file_id,
+                  stats::RunReport* report) {
+    if(args.shuffle == ShuffleMode::Process) {
+        return runProcessMapReduce(args, scheduler, sample_files, output, index_file, max_file_id, report);
+    }
+    int num_mappers = args.num_mappers;
+    int num_reducers = args.num_reducers;
+
+    // statisticile threadurilor, cate una pentru fiecare mapper si reducer
+    stats::MapperStats* mapper_stats = nullptr;
+    stats::ReducerStats* reducer_stats = nullptr;
+    if(report != nullptr) {
+        report->mappers.resize(report->mappers.size() + num_mappers);
+        report->reducers.resize(report->reducers.size() + num_reducers);
+        mapper_stats = &report->mappers[report->mappers.size() - num_mappers];
+        reducer_stats = &report->reducers[report->reducers.size() - num_reducers];
+    }
+    auto phase = stats::Clock::now();
+    auto endPhase = [&](const char* name) {
+        if(report != nullptr) report->addPhase(name, stats::secondsSince(phase));
+        phase = stats::Clock::now();
+    };
+
+    // Plasarea threadurilor (--affinity); reducerul i si mapperii cu
+    // acelasi numar relativ ajung pe acelasi nod NUMA
+    Placement placement(args.affinity);
+
+    // ReducerData comune, doar in modul --shuffle=shared; tabelele initiale
+    // se aloca pe nodul reducerului, dar cresterea lor (facuta de mapperi)
+    // urmeaza politica de memorie a mapperului
+    std::vector<std::unique_ptr<ReducerData>> reducers;
+    for(int i = 0; i < num_reducers && args.shuffle == ShuffleMode::Shared; i++) {
+        placement.allocateOn(i, num_reducers, [&]() {
+            reducers.push_back(makeReducerData(args.backend));
+        });
+    }
+
+    // Dictionarul global de termeni, comun mapperilor si reducerilor
+    TermDictionary dict;
+
+    // Indexurile partiale ale mapperilor (doar in modul --shuffle=local);
+    // bugetul de memorie se imparte egal intre ele
+    std::vector<std::unique_ptr<PartialIndex>> partials;
+    if(args.shuffle == ShuffleMode::Local) {
+        for(int i = 0; i < num_mappers; i++) {
+            partials.push_back(std::make_unique<PartialIndex>(num_reducers, args.memory_budget / num_mappers));
+        }
+    }
+
+    // Directorul run-urilor varsate pe disc, sters la iesirea din functie
+    std::unique_ptr<SpillDirectory> spill_dir;
+    if(args.memory_budget != 0) {
+        spill_dir = std::make_unique<SpillDirectory>(args.spill_dir);
+        if(!spill_dir->isOpen()) {
+            std::cerr << "Eroare la crearea directorului temporar in: "
+                      << (args.spill_dir.empty() ? "$TMPDIR" : args.spill_dir) << std::endl;
+            return false;
+        }
+    }
+
+    // Controlul mapping-ului
+    MappingControl control;
+
+    // Asignează cuvintele către Reduceri cât mai echilibrat
+    Partitioner partitioner(num_reducers);
+    if(args.partition == PartitionMode::Load) {
+        partitioner.sample(sample_files);
+        partitioner.assignByLoad();
+    } else {
+        partitioner.assignByLetter();
+    }
+    endPhase("partition");
+
+    // Fisierele literelor, completate de ultimul reducer care o termina
+    // si scrise de oricare reducer liber
+    ReduceOutput<> reduce_output(partitioner, output);
+
+    // Pozitiile termenilor (--positions), adunate de mapperi si sortate de
+    // reduceri; blocurile raman in memorie pana la scrierea indexului
+    std::unique_ptr<PositionStore> positions;
+    if(args.positions) {
+        positions = std::make_unique<PositionStore>(partitioner, num_mappers, num_reducers);
+        reduce_output.positions = positions.get();
+        reduce_output.index->setPositions(positions.get());
+    }
+
+    // In modul --shuffle=stream reducerii pornesc inaintea mapperilor
+    std::unique_ptr<StreamShuffle> stream;
+    std::vector<std::thread> reducer_threads;
+    if(args.shuffle == ShuffleMode::Stream) {
+        stream = std::make_unique<StreamShuffle>(num_mappers, num_reducers);
+        for(int i = 0; i < num_reducers; i++) {
+            // mapperii ruleaza in acelasi timp: reducerii iau procesoarele urmatoare
+            int skip = placement.countOnNode(placement.nodeOf(i, num_reducers), num_mappers);
+            reducer_threads.push_back(placedThread(placement, i, num_reducers, skip,
+                                                   streamReducerFunction,
+                                                   i,
+                                                   partitioner.letters(i),
+                                                   std::ref(*stream),
+                                                   std::ref(reduce_output),
+                                                   std::cref(dict),
+                                                   reducer_stats != nullptr ? &reducer_stats[i] : nullptr));
+        }
+    }
+
+    // Imparte fisierele intre mapperi (cele mai mari primele); cu --positions
+    // fisierele nu se impart, pozitiile numara cuvintele de la inceputul lor
+    scheduler.distribute(num_mappers, args.positions ? 0 : args.chunk_size);
+    if(placement.policy() != AffinityPolicy::None && placement.numNodes() > 1) {
+        std::vector<int> nodes;
+        for(int i = 0; i < num_mappers; i++) nodes.push_back(placement.nodeOf(i, num_mappers));
+        scheduler.setWorkerNodes(std::move(nodes));
+    }
+
+    // Lanseaza mapper threads
+    std::vector<std::thread> mapper_threads;
+    for(int i = 0; i < num_mappers; i++) {
+        mapper_threads.emplace_back([&, i]() {
+            placement.pin(i, num_mappers);
+            MapperSink sink;
+            std::unique_ptr<StreamProducer> producer;
+            if(args.shuffle == ShuffleMode::Local) {
+                sink.local = partials[i].get();
+                sink.spill = spill_dir.get();
+            } else if(args.shuffle == ShuffleMode::Stream) {
+                producer = std::make_unique<StreamProducer>(*stream, i, num_reducers);
+                sink.stream = producer.get();
+            } else {
+                sink.reducers = &reducers;
+            }
+            if(positions != nullptr) {
+                sink.positions = &positions->collector(i);
+            }
+            MapperInput input(scheduler, i, args.prefetch, args.prefetch_io);
+            if(i == 0 && args.prefetch > 0 && args.prefetch_io == PrefetchEngine::Uring && !input.usesUring()) {
+                std::cerr << "io_uring nu este disponibil, se foloseste pread" << std::endl;
+            }
+            mapperFunction(input, i, partitioner, dict, sink,
+                           mapper_stats != nullptr ? &mapper_stats[i] : nullptr);
+        });
+    }
+
+    // Așteapta finalizarea mapper threads
+    for(auto& thread : mapper_threads) {
+        thread.join();
+    }
+
+    endPhase("map");
+
+    // Semnaleaza ca mapping-ul s-a terminat
+    control.setDone();
+
+    // Daca vreun mapper a depasit bugetul, toti reducerii interclaseaza
+    // run-urile de pe disc (iesirea unei litere trebuie sa aiba un singur tip)
+    bool spilled = false;
+    for(auto& partial : partials) {
+        spilled = spilled || partial->hasSpilled();
+    }
+    std::unique_ptr<SpillMerge> spill_merge;
+    std::unique_ptr<ReduceOutput<SpilledKey>> spill_output;
+    if(spilled) {
+        spill_merge = std::make_unique<SpillMerge>(*spill_dir, num_reducers);
+        spill_output = std::make_unique<ReduceOutput<SpilledKey>>(partitioner, output);
+    }
+
+    // Creează thread-urile Reducer (daca nu ruleaza deja)
+    for(int i = 0; i < num_reducers && args.shuffle != ShuffleMode::Stream; i++) {
+        std::vector<std::vector<IndexEntry>*> partial_runs;
+        std::vector<std::string> run_files;
+        for(auto& partial : partials) {
+            partial_runs.push_back(&partial->run(i));
+            const auto& files = partial->spilledRuns(i);
+            run_files.insert(run_files.end(), files.begin(), files.end());
+        }
+        if(spilled) {
+            reducer_threads.push_back(placedThread(placement, i, num_reducers, 0,
+                                                   spillReducerFunction,
+                                                   i,
+                                                   partitioner.letters(i),
+                                                   std::move(partial_runs),
+                                                   std::move(run_files),
+                                                   std::ref(*spill_merge),
+                                                   std::ref(*spill_output),
+                                                   std::cref(dict),
+                                                   reducer_stats != nullptr ? &reducer_stats[i] : nullptr));
             continue;
         }
+        reducer_threads.push_back(placedThread(placement, i, num_reducers, 0,
+                                               reducerFunction,
+                                               i,
+                                               partitioner.letters(i),
+                                               reducers.empty() ? nullptr : reducers[i].get(),
+                                               std::move(partial_runs),
+                                               std::ref(reduce_output),
+                                               std::cref(dict),
+                                               std::ref(control),
+                                               reducer_stats != nullptr ? &reducer_stats[i] : nullptr));
+    }
 
-        // Scrie cuvintele sortate în fisierul de ieșire
-        for(const auto& entry : words) {
-            output << entry.first << ":[";
-            size_t count = 0; 
-            for(auto it = entry.second.begin(); it != entry.second.end(); ++it, ++count) {
-                output << *it;
-                if(count < entry.second.size() - 1)
-                    output << " ";
+    // Așteaptă finalizarea thread-urilor Reducer
+    for(auto& thread : reducer_threads) {
+        thread.join();
+    }
+    endPhase("reduce");
+    if(spilled && spill_merge->failed) {
+        return false;
+    }
+
+    // Indexul binar, asamblat din segmentele literelor
+    IndexBuilder* index = spilled ? spill_output->index.get() : reduce_output.index.get();
+    if(index != nullptr && !index->write(index_file, max_file_id)) {
+        std::cerr << "Eroare la scrierea indexului: " << index_file << std::endl;
+        return false;
+    }
+    if(index != nullptr) {
+        endPhase("write_index");
+    }
+    return true;
+}
+
+// Scrie rezultatul final din segmentele indexului incremental: termenii
+// fiecarei litere se interclaseaza din segmente, doc-urile se traduc in
+// pozitiile din lista curenta, apoi litera se sorteaza si se scrie ca la
+// indexarea completa. Literele se impart intre num_threads threaduri.
+// In raport, threadurile apar dupa reducerii segmentului delta.
+bool writeFromSegments(const std::vector<const IndexFile*>& segments,
+                       const std::vector<uint32_t>& doc_map,
+                       const InputArgs& args,
+                       uint32_t num_files,
+                       stats::RunReport* report) {
+    TermDictionary dict;
+    std::unique_ptr<IndexBuilder> index;
+    if(args.output != OutputFormat::Text) {
+        index = std::make_unique<IndexBuilder>();
+    }
+
+    int num_threads = std::min(args.num_reducers, ALPHABET_SIZE);
+    stats::ReducerStats* thread_stats = nullptr;
+    if(report != nullptr) {
+        report->reducers.resize(report->reducers.size() + num_threads);
+        thread_stats = &report->reducers[report->reducers.size() - num_threads];
+    }
+
+    Placement placement(args.affinity);
+    std::atomic<int> next_letter{0};
+    std::vector<std::thread> threads;
+    for(int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            placement.pin(t, num_threads);
+            stats::ReducerStats* stats = thread_stats != nullptr ? &thread_stats[t] : nullptr;
+            OutputWriter writer;
+            std::vector<IndexEntry> words;
+            for(int l = next_letter++; l < ALPHABET_SIZE; l = next_letter++) {
+                char letter = static_cast<char>('a' + l);
+                stats::Clock::time_point start;
+                if(stats != nullptr) start = stats::Clock::now();
+                words.clear();
+                mergeSegmentLetter(segments, letter, doc_map, [&](std::string_view word, const std::vector<uint32_t>& ids) {
+                    Postings files;
+                    for(uint32_t id : ids) files.insert(static_cast<int>(id));
+                    words.emplace_back(dict.intern(word, hashWord(word)), std::move(files));
+                });
+                if(words.empty()) continue;
+
+                stats::Clock::time_point sort_start, write_start;
+                if(stats != nullptr) sort_start = stats::Clock::now();
+                sortWords(words, dict);
+                if(stats != nullptr) write_start = stats::Clock::now();
+                uint64_t written = writer.bytesWritten();
+                if(index != nullptr) {
+                    index->addLetter(letter, words, dict);
+                }
+                std::string output_filename = letterFileName(letter);
+                if(args.output != OutputFormat::Binary && !writer.writeFile(output_filename, words, dict)) {
+                    std::cerr << "Eroare la crearea fișierului de ieșire: " << output_filename << std::endl;
+                }
+                if(stats != nullptr) {
+                    stats->terms += words.size();
+                    stats->shuffle_seconds += std::chrono::duration<double>(sort_start - start).count();
+                    stats->sort_seconds += std::chrono::duration<double>(write_start - sort_start).count();
+                    stats->write_seconds += stats::secondsSince(write_start);
+                    stats->letters_written++;
+                    stats->output_bytes += writer.bytesWritten() - written;
+                }
             }
-            output << "]\n";
+        });
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    if(index != nullptr && !index->write(args.index_file, num_files)) {
+        std::cerr << "Eroare la scrierea indexului: " << args.index_file << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Indexarea incrementala (--incremental=<director>): doar fisierele noi sau
+// modificate fata de manifest se mapeaza, intr-un segment nou; segmentele se
+// compacteaza, apoi rezultatul se scrie din segmente
+bool runIncremental(const InputArgs& args, const std::vector<std::string>& file_names,
+                    stats::RunReport* report) {
+    std::error_code error;
+    std::filesystem::create_directories(args.incremental_dir, error);
+    Manifest manifest(args.incremental_dir);
+    if(!manifest.load()) {
+        std::cerr << "Manifest invalid in: " << args.incremental_dir << std::endl;
+        return false;
+    }
+    // segmentele existente trebuie sa aiba aceeasi normalizare
+    for(const auto& name : manifest.segmentNames()) {
+        IndexFile segment;
+        if(segment.open(manifest.pathOf(name)) && segment.normalizeMode() != args.normalize) {
+            std::cerr << "Indexul incremental a fost construit cu alt --normalize: "
+                      << args.incremental_dir << std::endl;
+            return false;
+        }
+    }
+
+    auto start = stats::Clock::now();
+    std::vector<uint32_t> doc_map;
+    std::vector<DeltaFile> delta = manifest.update(file_names, doc_map);
+    if(report != nullptr) report->addPhase("manifest", stats::secondsSince(start));
+    if(!delta.empty()) {
+        // segmentul delta foloseste doc-urile stabile ca file_id
+        WorkStealingScheduler scheduler;
+        std::vector<std::string> delta_names;
+        for(const auto& file : delta) {
+            scheduler.addFile(file.path, static_cast<int>(file.doc));
+            delta_names.push_back(file.path);
+        }
+        std::string segment = manifest.newSegmentName();
+        if(!runMapReduce(args, scheduler, delta_names, OutputFormat::Binary,
+                         manifest.pathOf(segment), manifest.maxDoc(), report)) {
+            return false;
+        }
+        manifest.addSegment(segment);
+    }
+    start = stats::Clock::now();
+    if(!manifest.save() || !compactSegments(manifest, doc_map)) {
+        std::cerr << "Eroare la actualizarea indexului incremental: " << args.incremental_dir << std::endl;
+        return false;
+    }
+    if(report != nullptr) report->addPhase("compact", stats::secondsSince(start));
+
+    std::vector<std::unique_ptr<IndexFile>> files;
+    std::vector<const IndexFile*> segments;
+    for(const auto& name : manifest.segmentNames()) {
+        files.push_back(std::make_unique<IndexFile>());
+        if(!files.back()->open(manifest.pathOf(name))) {
+            std::cerr << "Segment invalid: " << manifest.pathOf(name) << std::endl;
+            return false;
+        }
+        segments.push_back(files.back().get());
+    }
+    start = stats::Clock::now();
+    bool ok = writeFromSegments(segments, doc_map, args, static_cast<uint32_t>(file_names.size()), report);
+    if(report != nullptr) report->addPhase("write_segments", stats::secondsSince(start));
+    return ok;
+}
+
+// Subcomenzile care folosesc un index binar deja construit:
+// ./tema1 query <index> [interogare]   (fara interogare: cate una pe linie, din stdin)
+// ./tema1 serve <index> <socket>
+// ./tema1 bench <socket> <fisier_interogari> [iteratii]
+bool isSubcommand(const std::string& name) {
+    return name == "query" || name == "serve" || name == "bench";
+}
+
+int runSubcommand(int argc, char** argv) {
+    std::string command = argv[1];
+    if(command == "bench") {
+        if(argc < 4 || argc > 5) {
+            throw std::invalid_argument("Utilizare: bench <socket> <fisier_interogari> [iteratii]");
+        }
+        std::ifstream input(argv[3]);
+        if(!input.is_open()) {
+            std::cerr << "Eroare la deschiderea fișierului de interogari: " << argv[3] << std::endl;
+            return EXIT_FAILURE;
         }
+        std::vector<std::string> queries;
+        for(std::string line; std::getline(input, line);) {
+            if(!line.empty()) queries.push_back(line);
+        }
+        int iterations = argc == 5 ? std::stoi(argv[4]) : 1000;
+        if(iterations <= 0) {
+            throw std::invalid_argument("Numarul de iteratii trebuie sa fie pozitiv");
+        }
+        return runQueryBench(argv[2], queries, iterations);
+    }
 
-        output.close();
+    if(argc < 3 || (command == "serve" && argc != 4)) {
+        throw std::invalid_argument("Utilizare: " + command + (command == "serve" ? " <index> <socket>"
+                                                                                   : " <index> [interogare]"));
+    }
+    IndexFile index;
+    if(!index.open(argv[2])) {
+        std::cerr << "Index invalid: " << argv[2] << std::endl;
+        return EXIT_FAILURE;
     }
+    // cuvintele interogarilor se normalizeaza ca termenii indexului
+    activeNormalizeMode() = index.normalizeMode();
+    if(command == "serve") {
+        return runQueryServer(index, argv[3]);
+    }
+
+    // query: interogarea din argumente sau, fara ea, cate una pe linie din stdin
+    QueryEngine engine(index);
+    std::vector<uint32_t> ids;
+    std::string response;
+    auto answer = [&](const std::string& query) {
+        try {
+            engine.run(query, ids);
+            formatResult(ids, response);
+        } catch(const std::invalid_argument& e) {
+            response = std::string("ERR ") + e.what() + "\n";
+        }
+        std::cout << response;
+    };
+    if(argc > 3) {
+        std::string query;
+        for(int i = 3; i < argc; i++) {
+            if(i > 3) query += ' ';
+            query += argv[i];
+        }
+        answer(query);
+    } else {
+        for(std::string line; std::getline(std::cin, line);) {
+            answer(line);
+        }
+    }
+    std::cout.flush();
+    return EXIT_SUCCESS;
 }
 
+// Scrie raportul --stats, cu configuratia rularii ("-" = stdout)
+bool writeStatsReport(stats::RunReport& report, const InputArgs& args, int num_files) {
+    auto quoted = [](const char* value) {
+        return std::string("\"") + value + "\"";
+    };
+    const char* shuffle[] = {"local", "shared", "stream", "process"};
+    const char* partition[] = {"letter", "load"};
+    const char* output[] = {"text", "binary", "both"};
+    const char* affinity[] = {"none", "cores", "nodes", "auto"};
+    const char* normalize[] = {"ascii", "utf8", "fold"};
+    report.config = {
+        {"mappers", std::to_string(args.num_mappers)},
+        {"reducers", std::to_string(args.num_reducers)},
+        {"files", std::to_string(num_files)},
+        {"shuffle", quoted(shuffle[static_cast<int>(args.shuffle)])},
+        {"backend", quoted(args.backend == IndexBackend::Map ? "map" : "hash")},
+        {"partition", quoted(partition[static_cast<int>(args.partition)])},
+        {"chunk_size", std::to_string(args.chunk_size)},
+        {"output", quoted(output[static_cast<int>(args.output)])},
+        {"incremental", args.incremental_dir.empty() ? "false" : "true"},
+        {"prefetch", std::to_string(args.prefetch)},
+        {"normalize", quoted(normalize[static_cast<int>(args.normalize)])},
+        {"positions", args.positions ? "true" : "false"},
+        {"affinity", quoted(affinity[static_cast<int>(Placement(args.affinity).policy())])},
+    };
+    if(args.stats_file == "-") {
+        report.write(std::cout);
+        return bool(std::cout.flush());
+    }
+    std::ofstream out(args.stats_file);
+    report.write(out);
+    return bool(out.flush());
+}
 
 int main(int argc, char** argv) {
     try {
+        if(argc >= 2 && isSubcommand(argv[1])) {
+            return runSubcommand(argc, argv);
+        }
+
         // Verificare argumente
         InputArgs args = parseInputArgs(argc, argv);
-        int num_mappers = args.num_mappers;
-        int num_reducers = args.num_reducers;
         std::string input_file = args.input_file;
-        
+        activeNormalizeMode() = args.normalize;
+
+        // Raportul --stats; fara el threadurile primesc pointeri nuli
+        std::unique_ptr<stats::RunReport> report;
+        if(!args.stats_file.empty()) {
+            stats::enabled = true;
+            report = std::make_unique<stats::RunReport>();
+        }
+        auto start = stats::Clock::now();
+
         // Deschide fișierul de intrare
         std::ifstream input(input_file);
         if(!input.is_open()) {
@@ -349,7 +1388,8 @@ int main(int argc, char** argv) {
         }
 
         // Citește numele fisierelor
-        ThreadSafeFilesQueue queue;
+        WorkStealingScheduler scheduler;
+        std::vector<std::string> file_names;
         for(int i = 0; i < num_files; i++) {
             std::string file_name;
             input >> file_name;
@@ -357,70 +1397,30 @@ int main(int argc, char** argv) {
                 std::cerr << "Eroare la citirea numelui fișierului." << std::endl;
                 return EXIT_FAILURE;
             }
-            queue.addFile(file_name);
+            scheduler.addFile(file_name);
+            file_names.push_back(file_name);
         }
         input.close();
-
-        // Initializeaza reducerii
-        std::vector<std::unique_ptr<ReducerData>> reducers;
-        for(int i = 0; i < num_reducers; i++) {
-            reducers.push_back(std::make_unique<ReducerData>());
-        }
-
-        // Controlul mapping-ului
-        MappingControl control;
-
-        // Creează thread pool pentru mappers
-        ThreadPool mapper_pool(num_mappers);
-        std::vector<std::future<void>> mapper_futures;
-
-        // Lanseaza mapper threads
-        for(int i = 0; i < num_mappers; i++) {
-            mapper_futures.push_back(mapper_pool.enqueue([&]() {
-                mapperFunction(queue, reducers, num_reducers);
-            }));
+        if(report != nullptr) {
+            report->addPhase("read_input", stats::secondsSince(start));
         }
 
-        // Așteapta finalizarea mapper threads
-        for(auto& future : mapper_futures) {
-            future.wait();
+        bool ok;
+        if(args.incremental_dir.empty()) {
+            ok = runMapReduce(args, scheduler, file_names, args.output, args.index_file,
+                              static_cast<uint32_t>(scheduler.size()), report.get());
+        } else {
+            ok = runIncremental(args, file_names, report.get());
         }
-
-        // Semnaleaza ca mapping-ul s-a terminat
-        control.setDone();
-
-        // Configurarea reducerilor
-        std::vector<std::thread> reducer_threads;
-        std::vector<std::vector<char>> reducer_letter_assignments(num_reducers);
-
-        // Asignează literele alfabetului către Reduceri cât mai echilibrat
-        int letters_per_reducer = ALPHABET_SIZE / num_reducers;
-        int extra_letters = ALPHABET_SIZE % num_reducers;
-        int current_letter = 0;
-
-        for(int i = 0; i < num_reducers; i++) {
-            int assigned_letters = letters_per_reducer + (i < extra_letters ? 1 : 0);
-            for(int j = 0; j < assigned_letters && current_letter < ALPHABET_SIZE; j++, current_letter++) {
-                char letter = 'a' + current_letter;
-                reducer_letter_assignments[i].push_back(letter);
-            }
-        }
-
-        // Creează thread-urile Reducer
-        for(int i = 0; i < num_reducers; i++) {
-            reducer_threads.emplace_back(reducerFunction, 
-                                         reducer_letter_assignments[i], 
-                                         reducers[i].get(), 
-                                         std::ref(control));
+        if(!ok) {
+            return EXIT_FAILURE;
         }
 
-        // Așteaptă finalizarea thread-urilor Reducer
-        for(auto& thread : reducer_threads) {
-            thread.join();
+        if(report != nullptr && !writeStatsReport(*report, args, num_files)) {
+            std::cerr << "Eroare la scrierea raportului: " << args.stats_file << std::endl;
+            return EXIT_FAILURE;
         }
 
-    
-
         std::cout << "Procesarea a fost finalizată cu succes." << std::endl;
 
         return EXIT_SUCCESS;
@@ -0,0 +1,180 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <charconv>
+#include <cstdint>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "postings.h"
+#include "term_dictionary.h"
+#include "tokenizer.h"
+
+// Numele fisierului de iesire al unei litere
+inline std::string letterFileName(char letter) {
+    return letter == OTHER_LETTER ? "altele.txt" : std::string(1, letter) + ".txt";
+}
+
+// Scrie fisierele de iesire printr-un buffer mare, refolosit intre fisiere:
+// numerele se formateaza cu std::to_chars direct in buffer, iar buffer-ul
+// se goleste cu apeluri write() de cate BUFFER_SIZE octeti
+class OutputWriter {
+private:
+    static const size_t BUFFER_SIZE = 1 << 20;
+    // cel mai lung numar (int) plus separatorul
+    static const size_t MAX_NUMBER = 12;
+
+    std::unique_ptr<char[]> buffer;
+    size_t used = 0;
+    int fd = -1;
+    bool failed = false;
+    uint64_t written = 0; // octetii scrisi de la crearea writer-ului
+
+    void flush() {
+        size_t done = 0;
+        while(done < used && !failed) {
+            ssize_t n = ::write(fd, buffer.get() + done, used - done);
+            if(n < 0) {
+                failed = true;
+            } else {
+                done += static_cast<size_t>(n);
+                written += static_cast<uint64_t>(n);
+            }
+        }
+        used = 0;
+    }
+
+    void append(std::string_view text) {
+        while(!text.empty()) {
+            if(used == BUFFER_SIZE) flush();
+            size_t n = std::min(text.size(), BUFFER_SIZE - used);
+            std::memcpy(buffer.get() + used, text.data(), n);
+            used += n;
+            text.remove_prefix(n);
+        }
+    }
+
+    void appendNumber(int value, char separator) {
+        if(BUFFER_SIZE - used < MAX_NUMBER) flush();
+        char* end = std::to_chars(buffer.get() + used, buffer.get() + BUFFER_SIZE, value).ptr;
+        *end++ = separator;
+        used = end - buffer.get();
+    }
+
+public:
+    OutputWriter() : buffer(new char[BUFFER_SIZE]) {}
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    uint64_t bytesWritten() const {
+        return written;
+    }
+
+    // scrie cuvintele (deja sortate) in fisierul dat, in formatul word:[1 2 3]
+    bool writeFile(const std::string& file_name,
+                   const std::vector<IndexEntry>& words,
+                   const TermDictionary& dict) {
+        if(!open(file_name)) {
+            return false;
+        }
+        for(const auto& entry : words) {
+            addWord(dict.resolve(entry.first), entry.second.size(), [&entry](auto&& emit) {
+                entry.second.forEach(emit);
+            });
+        }
+        return close();
+    }
+
+    // scrierea pas cu pas, pentru cuvinte care nu sunt intr-un vector de
+    // IndexEntry: open, addWord pentru fiecare cuvant, close
+    bool open(const std::string& file_name) {
+        fd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        used = 0;
+        failed = false;
+        return fd >= 0;
+    }
+
+    // for_each_id(emit) trebuie sa apeleze emit(id) pentru cele count id-uri
+    template<class F>
+    void addWord(std::string_view word, size_t count, F&& for_each_id) {
+        append(word);
+        append(":[");
+        size_t remaining = count;
+        for_each_id([&](int file_id) {
+            appendNumber(file_id, --remaining > 0 ? ' ' : ']');
+        });
+        if(count == 0) append("]");
+        append("\n");
+    }
+
+    bool close() {
+        flush();
+        failed |= ::close(fd) != 0;
+        fd = -1;
+        return !failed;
+    }
+};
+
+// Coada literelor gata de scris. Reducerul care termina o litera o pune
+// in coada, iar orice reducer care si-a terminat partitia scrie fisierele
+// din coada, deci fisierele se scriu in paralel, nu doar de proprietarul
+// literei.
+// Entry este tipul cuvintelor unei litere (IndexEntry, sau cheile
+// postarilor varsate pe disc la indexarea cu buget de memorie).
+template<class Entry = IndexEntry>
+class LetterWriteQueue {
+private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::pair<char, std::vector<Entry>>> ready;
+    int pending; // literele inca nefinalizate
+
+public:
+    explicit LetterWriteQueue(int letters) : pending(letters) {}
+
+    // litera e completa; o litera fara cuvinte (inclusiv OTHER_LETTER) nu
+    // mai produce fisier, ca in tema originala
+    void submit(char letter, std::vector<Entry>&& words) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending--;
+            if(!words.empty()) {
+                ready.emplace_back(letter, std::move(words));
+            }
+        }
+        cond.notify_all();
+    }
+
+    // preia literele din coada pana cand toate literele au fost scrise;
+    // write_letter(letter, words, writer) scrie o litera
+    template<class F>
+    void work(F&& write_letter) {
+        OutputWriter writer;
+        std::unique_lock<std::mutex> lock(mutex);
+        for(;;) {
+            cond.wait(lock, [this] { return !ready.empty() || pending == 0; });
+            if(ready.empty()) {
+                return;
+            }
+            auto [letter, words] = std::move(ready.front());
+            ready.pop_front();
+            lock.unlock();
+
+            write_letter(letter, words, writer);
+            words = {};
+            lock.lock();
+        }
+    }
+};
+
+#endif // OUTPUT_WRITER_H
@@ -0,0 +1,153 @@
+#ifndef PARTIAL_INDEX_H
+#define PARTIAL_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "postings.h"
+#include "spill.h"
+#include "term_dictionary.h"
+
+// Index partial construit de un singur mapper, impartit pe partitii
+// (cate una pentru fiecare reducer). Fiecare mapper are propriul index,
+// deci inserarile nu au nevoie de lock-uri.
+// Cu un buget de memorie, indexul isi estimeaza dimensiunea, iar cand o
+// depaseste mapper-ul il varsa pe disc (spill), ca run-uri sortate.
+class PartialIndex {
+private:
+    // costul estimat al unei intrari noi in unordered_map: nodul (cu
+    // pointerul urmator si hash-ul retinut) si bucket-ul
+    static const size_t ENTRY_BYTES = sizeof(IndexEntry) + 4 * sizeof(void*);
+
+    std::vector<std::unordered_map<TermId, Postings>> partitions;
+    std::vector<std::vector<IndexEntry>> runs; // run-urile sortate, dupa seal()
+    uint64_t budget = 0; // 0 = fara limita
+    uint64_t used = 0; // memoria estimata a partitiilor
+    std::vector<std::vector<std::string>> spilled; // run-urile de pe disc ale fiecarei partitii
+
+    // muta partitia intr-un run sortat dupa TermId
+    void sortPartition(size_t p, std::vector<IndexEntry>& run) {
+        run.reserve(partitions[p].size());
+        for(auto& entry : partitions[p]) {
+            run.emplace_back(entry.first, std::move(entry.second));
+        }
+        partitions[p] = {};
+        std::sort(run.begin(), run.end(),
+                  [](const IndexEntry& a, const IndexEntry& b) { return a.first < b.first; });
+    }
+
+public:
+    explicit PartialIndex(int num_partitions, uint64_t budget_bytes = 0)
+        : partitions(num_partitions), runs(num_partitions), budget(budget_bytes),
+          spilled(num_partitions) {}
+
+    // adauga aparitia termenului in fisierul dat
+    void add(int partition, TermId term, int file_id) {
+        if(budget == 0) {
+            partitions[partition][term].insert(file_id);
+            return;
+        }
+        auto [it, inserted] = partitions[partition].try_emplace(term);
+        used -= it->second.heapBytes(); // trecerea la bitmap poate micsora lista
+        it->second.insert(file_id);
+        used += it->second.heapBytes() + (inserted ? ENTRY_BYTES : 0);
+    }
+
+    bool overBudget() const {
+        return budget != 0 && used > budget;
+    }
+
+    // scrie fiecare partitie nevida ca run in directorul dat si elibereaza
+    // memoria; name_prefix face numele unice intre mapperi. Intoarce false
+    // la o eroare de scriere; bytes primeste octetii scrisi.
+    bool spill(const SpillDirectory& dir, const std::string& name_prefix, uint64_t& bytes) {
+        bytes = 0;
+        std::vector<IndexEntry> run;
+        for(size_t p = 0; p < partitions.size(); p++) {
+            if(partitions[p].empty()) continue;
+            run.clear();
+            sortPartition(p, run);
+            std::string path = dir.pathOf(name_prefix + "-p" + std::to_string(p) + "-" +
+                                          std::to_string(spilled[p].size()) + ".run");
+            uint64_t run_bytes = 0;
+            if(!writeRun(path, run, run_bytes)) {
+                return false;
+            }
+            spilled[p].push_back(path);
+            bytes += run_bytes;
+        }
+        used = 0;
+        return true;
+    }
+
+    // transforma fiecare partitie intr-un run sortat dupa TermId
+    void seal() {
+        for(size_t p = 0; p < partitions.size(); p++) {
+            sortPartition(p, runs[p]);
+        }
+        used = 0;
+    }
+
+    // run-ul sortat al partitiei (valid dupa seal())
+    std::vector<IndexEntry>& run(int partition) {
+        return runs[partition];
+    }
+
+    // run-urile partitiei varsate pe disc
+    const std::vector<std::string>& spilledRuns(int partition) const {
+        return spilled[partition];
+    }
+
+    bool hasSpilled() const {
+        for(const auto& files : spilled) {
+            if(!files.empty()) return true;
+        }
+        return false;
+    }
+};
+
+// Interclaseaza (k-way merge) run-urile sortate ale unei partitii intr-o
+// singura lista sortata dupa TermId. Run-urile sunt consumate (mutate).
+inline std::vector<IndexEntry> mergeRuns(const std::vector<std::vector<IndexEntry>*>& runs) {
+    // (indexul run-ului, pozitia curenta in run)
+    using Cursor = std::pair<size_t, size_t>;
+    auto greater = [&runs](const Cursor& a, const Cursor& b) {
+        return (*runs[a.first])[a.second].first > (*runs[b.first])[b.second].first;
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
+
+    size_t total = 0;
+    for(size_t r = 0; r < runs.size(); r++) {
+        total += runs[r]->size();
+        if(!runs[r]->empty()) {
+            heap.push({r, 0});
+        }
+    }
+
+    std::vector<IndexEntry> merged;
+    merged.reserve(total);
+    while(!heap.empty()) {
+        Cursor cur = heap.top();
+        heap.pop();
+        IndexEntry& entry = (*runs[cur.first])[cur.second];
+
+        if(!merged.empty() && merged.back().first == entry.first) {
+            // acelasi termen din alt run: se reunesc listele de fisiere
+            merged.back().second.unionWith(entry.second);
+        } else {
+            merged.push_back(std::move(entry));
+        }
+
+        if(cur.second + 1 < runs[cur.first]->size()) {
+            heap.push({cur.first, cur.second + 1});
+        }
+    }
+    return merged;
+}
+
+#endif // PARTIAL_INDEX_H
@@ -0,0 +1,160 @@
+#ifndef PARTITIONER_H
+#define PARTITIONER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "compressed_input.h"
+#include "input_reader.h"
+#include "tokenizer.h"
+
+// Celula de prefix a unui cuvant normalizat: litera lui (vezi letterOf) si
+// a doua litera (lipsa ei, a..z sau una non-ASCII), adica 27 * 28 celule
+// ordonate alfabetic
+using PrefixCell = uint16_t;
+
+const int SECOND_LETTERS = 28;
+const int PREFIX_CELLS = LETTER_SLOTS * SECOND_LETTERS;
+
+// word trebuie sa fie nevid si format doar din litere mici
+inline PrefixCell prefixCell(std::string_view word) {
+    int second = 0;
+    if(word.size() > 1) {
+        unsigned char c = static_cast<unsigned char>(word[1]);
+        second = c < 0x80 ? c - 'a' + 1 : SECOND_LETTERS - 1;
+    }
+    return static_cast<PrefixCell>((letterOf(word) - 'a') * SECOND_LETTERS + second);
+}
+
+// Imparte celulele de prefix intre reduceri. Fiecare reducer primeste un
+// interval contiguu de celule (ordinea alfabetica se pastreaza), ales astfel
+// incat incarcarea estimata sa fie cat mai egala; o litera frecventa se poate
+// imparti intre mai multi reduceri (ex. "sa"-"sh" si "si"-"sz"), deci pot fi
+// folositi si mai mult de 26 de reduceri. Maparea celula -> reducer se
+// calculeaza o singura data, intr-un tabel.
+class Partitioner {
+private:
+    // esantionul: primii SAMPLE_BYTES octeti din cel mult SAMPLE_FILES fisiere
+    static const size_t SAMPLE_FILES = 16;
+    static const size_t SAMPLE_BYTES = 64 * 1024;
+
+    int num_reducers;
+    std::vector<uint64_t> load; // incarcarea estimata a fiecarei celule
+    std::vector<int> cell_reducer; // reducerul fiecarei celule
+    std::vector<std::vector<char>> reducer_letters; // literele atinse de fiecare reducer
+    std::vector<int> letter_reducers; // cati reduceri primesc cuvinte din fiecare litera
+
+    void assign(const std::vector<int>& reducer_of_cell) {
+        cell_reducer = reducer_of_cell;
+        reducer_letters.assign(num_reducers, {});
+        letter_reducers.assign(LETTER_SLOTS, 0);
+        for(int cell = 0; cell < PREFIX_CELLS; cell++) {
+            int r = cell_reducer[cell];
+            char letter = static_cast<char>('a' + cell / SECOND_LETTERS);
+            if(reducer_letters[r].empty() || reducer_letters[r].back() != letter) {
+                reducer_letters[r].push_back(letter);
+                letter_reducers[letter - 'a']++;
+            }
+        }
+    }
+
+public:
+    explicit Partitioner(int reducers) : num_reducers(reducers), load(PREFIX_CELLS, 1) {}
+
+    // estimeaza incarcarea celulelor din termenii distincti ai unui
+    // esantion de fisiere, alese uniform din lista
+    void sample(const std::vector<std::string>& files) {
+        size_t step = files.size() / SAMPLE_FILES + 1;
+        // cuvintele primite de la tokenizator sunt valide doar in apel
+        std::unordered_set<std::string> seen;
+        std::vector<char> decompressed;
+        for(size_t i = 0; i < files.size(); i += step) {
+            MappedFile file(files[i]);
+            if(!file.isOpen()) continue;
+            std::string_view text = file.data();
+            seen.clear();
+            auto count = [&](std::string_view word) {
+                if(seen.emplace(word).second) {
+                    load[prefixCell(word)]++;
+                }
+            };
+            Compression format = detectCompression(text);
+            if(format == Compression::None) {
+                text = text.substr(0, chunkBoundary(text, SAMPLE_BYTES));
+                forEachNormalizedWord(text, count);
+                continue;
+            }
+            // din fisierele comprimate se decomprima doar inceputul
+            NormalizedWordStream words;
+            size_t sampled = 0;
+            forEachDecompressedBlock(text, format, decompressed, [&](std::string_view block) {
+                words.feed(block, count);
+                sampled += block.size();
+                return sampled < SAMPLE_BYTES;
+            });
+            words.finish(count);
+        }
+    }
+
+    // impartirea initiala: intervale egale de litere, fara estimari;
+    // primii 26 % R reduceri primesc o litera in plus, iar OTHER_LETTER
+    // merge la ultimul reducer
+    void assignByLetter() {
+        std::vector<int> reducer_of_letter(LETTER_SLOTS, num_reducers - 1);
+        int letter = 0;
+        for(int r = 0; r < num_reducers && letter < 26; r++) {
+            int count = 26 / num_reducers + (r < 26 % num_reducers ? 1 : 0);
+            for(int j = 0; j < count && letter < 26; j++) {
+                reducer_of_letter[letter++] = r;
+            }
+        }
+        std::vector<int> reducer_of_cell(PREFIX_CELLS);
+        for(int cell = 0; cell < PREFIX_CELLS; cell++) {
+            reducer_of_cell[cell] = reducer_of_letter[cell / SECOND_LETTERS];
+        }
+        assign(reducer_of_cell);
+    }
+
+    // impartirea dupa incarcare: celula merge la reducerul in al carui
+    // interval [r, r+1) * total / R cade mijlocul ei in suma prefix. Cu
+    // whole_letters unitatea este litera (toate celulele ei), deci fiecare
+    // litera ajunge la un singur reducer (--shuffle=process).
+    void assignByLoad(bool whole_letters = false) {
+        int unit = whole_letters ? SECOND_LETTERS : 1;
+        uint64_t total = 0;
+        for(uint64_t l : load) total += l;
+        std::vector<int> reducer_of_cell(PREFIX_CELLS);
+        uint64_t before = 0;
+        for(int first = 0; first < PREFIX_CELLS; first += unit) {
+            uint64_t weight = 0;
+            for(int cell = first; cell < first + unit; cell++) weight += load[cell];
+            uint64_t middle = 2 * before + weight; // de doua ori mijlocul
+            uint64_t r = middle * num_reducers / (2 * total);
+            for(int cell = first; cell < first + unit; cell++) {
+                reducer_of_cell[cell] = static_cast<int>(std::min<uint64_t>(r, num_reducers - 1));
+            }
+            before += weight;
+        }
+        assign(reducer_of_cell);
+    }
+
+    int reducerFor(PrefixCell cell) const {
+        return cell_reducer[cell];
+    }
+
+    // literele din care reducerul poate primi cuvinte (crescator)
+    const std::vector<char>& letters(int reducer) const {
+        return reducer_letters[reducer];
+    }
+
+    // numarul de reduceri intre care e impartita litera
+    int reducersForLetter(char letter) const {
+        return letter_reducers[letter - 'a'];
+    }
+};
+
+#endif // PARTITIONER_H
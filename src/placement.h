@@ -0,0 +1,193 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Plasarea threadurilor pe procesoare si noduri NUMA (--affinity).
+// Topologia se citeste din sysfs si se intersecteaza cu procesoarele
+// permise procesului (sched_getaffinity), deci un container cu cpuset
+// restrans vede doar ce are voie sa foloseasca. Orice esec (sysfs lipsa,
+// set_mempolicy interzis) lasa threadul neplasat, fara eroare.
+
+enum class AffinityPolicy {
+    None, // planificatorul sistemului decide (implicit)
+    Cores, // fiecare thread pe un procesor
+    Nodes, // fiecare thread pe procesoarele unui nod, cu memoria pe acel nod
+    Auto // Nodes pe masinile cu mai multe noduri, altfel None
+};
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+inline std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while(pos < text.size()) {
+        size_t comma = text.find(',', pos);
+        if(comma == std::string::npos) comma = text.size();
+        std::string range = text.substr(pos, comma - pos);
+        pos = comma + 1;
+        if(range.empty() || !isdigit(static_cast<unsigned char>(range[0]))) continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for(int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Nodurile NUMA cu cel putin un procesor permis, ordonate dupa id
+struct Topology {
+    std::vector<int> node_ids; // -1 cand sysfs nu descrie nodurile
+    std::vector<std::vector<int>> cpus; // procesoarele permise ale fiecarui nod
+
+    static Topology detect() {
+        Topology topology;
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            return topology;
+        }
+
+        std::vector<std::pair<int, std::vector<int>>> nodes;
+        std::error_code error;
+        for(const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+            std::string name = entry.path().filename().string();
+            if(name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+               !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+                continue;
+            }
+            std::ifstream in(entry.path() / "cpulist");
+            std::string list;
+            std::getline(in, list);
+            std::vector<int> node_cpus;
+            for(int cpu : parseCpuList(list)) {
+                if(cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) node_cpus.push_back(cpu);
+            }
+            if(!node_cpus.empty()) nodes.emplace_back(std::stoi(name.substr(4)), std::move(node_cpus));
+        }
+        std::sort(nodes.begin(), nodes.end());
+        for(auto& [id, node_cpus] : nodes) {
+            topology.node_ids.push_back(id);
+            topology.cpus.push_back(std::move(node_cpus));
+        }
+
+        // fara noduri in sysfs: un singur "nod" cu toate procesoarele permise
+        if(topology.cpus.empty()) {
+            std::vector<int> all;
+            for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if(CPU_ISSET(cpu, &allowed)) all.push_back(cpu);
+            }
+            if(!all.empty()) {
+                topology.node_ids.push_back(-1);
+                topology.cpus.push_back(std::move(all));
+            }
+        }
+        return topology;
+    }
+};
+
+// Plasarea unui grup de n threaduri (mapperii sau reducerii): threadurile
+// se impart pe noduri in blocuri contigue, in proportii egale, deci
+// mapperii si reducerii cu acelasi numar relativ stau pe acelasi nod
+class Placement {
+private:
+    AffinityPolicy policy_ = AffinityPolicy::None;
+    Topology topology;
+
+    // primul thread din grupul de n plasat pe nodul dat
+    int firstOnNode(int node, int n) const {
+        int nodes = numNodes();
+        return static_cast<int>((static_cast<int64_t>(node) * n + nodes - 1) / nodes);
+    }
+
+    // politica de memorie a threadului curent: nodul preferat sau implicita
+    static bool setMemoryPolicy(int node_id) {
+        if(node_id < 0) {
+            return syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0) == 0;
+        }
+        const unsigned long bits = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> mask(node_id / bits + 1, 0);
+        mask[node_id / bits] = 1ul << (node_id % bits);
+        return syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), mask.size() * bits + 1) == 0;
+    }
+
+public:
+    Placement() = default;
+
+    explicit Placement(AffinityPolicy requested) : policy_(requested) {
+        if(policy_ == AffinityPolicy::None) {
+            return;
+        }
+        topology = Topology::detect();
+        if(topology.cpus.empty()) {
+            policy_ = AffinityPolicy::None;
+        } else if(policy_ == AffinityPolicy::Auto) {
+            policy_ = topology.cpus.size() > 1 ? AffinityPolicy::Nodes : AffinityPolicy::None;
+        }
+    }
+
+    // politica efectiva (Auto e deja rezolvata)
+    AffinityPolicy policy() const {
+        return policy_;
+    }
+
+    int numNodes() const {
+        return std::max<int>(1, static_cast<int>(topology.cpus.size()));
+    }
+
+    // nodul threadului k dintr-un grup de n
+    int nodeOf(int k, int n) const {
+        if(topology.cpus.empty()) return 0;
+        return static_cast<int>(static_cast<int64_t>(k) * numNodes() / n);
+    }
+
+    // cate threaduri din grupul de n ajung pe nodul dat
+    int countOnNode(int node, int n) const {
+        return firstOnNode(node + 1, n) - firstOnNode(node, n);
+    }
+
+    // plaseaza threadul curent ca al k-lea din grupul de n; skip sare peste
+    // primele procesoare ale nodului (ocupate de un grup care ruleaza in
+    // acelasi timp, de exemplu mapperii in modul --shuffle=stream)
+    void pin(int k, int n, int skip = 0) const {
+        if(policy_ == AffinityPolicy::None) {
+            return;
+        }
+        int node = nodeOf(k, n);
+        const std::vector<int>& cpus = topology.cpus[node];
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if(policy_ == AffinityPolicy::Cores) {
+            size_t j = static_cast<size_t>(k - firstOnNode(node, n) + skip);
+            CPU_SET(cpus[j % cpus.size()], &set);
+        } else {
+            for(int cpu : cpus) CPU_SET(cpu, &set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if(policy_ == AffinityPolicy::Nodes && topology.cpus.size() > 1) {
+            setMemoryPolicy(topology.node_ids[node]);
+        }
+    }
+
+    // ruleaza alloc() cu memoria threadului curent preferata pe nodul
+    // threadului k din grupul de n (paginile atinse acum raman acolo)
+    template<class F>
+    void allocateOn(int k, int n, F&& alloc) const {
+        bool placed = policy_ == AffinityPolicy::Nodes && topology.cpus.size() > 1 &&
+                      setMemoryPolicy(topology.node_ids[nodeOf(k, n)]);
+        alloc();
+        if(placed) setMemoryPolicy(-1);
+    }
+};
+
+#endif // PLACEMENT_H
@@ -0,0 +1,344 @@
+#ifndef POSITIONS_H
+#define POSITIONS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "partitioner.h"
+#include "postings.h"
+#include "term_dictionary.h"
+
+// Indexul pozitional (--positions). Pentru fiecare pereche (termen, fisier)
+// se pastreaza frecventa termenului (tf) si pozitiile lui in fisier (al
+// catelea cuvant normalizat este), codificate varint ca diferente:
+//   payload := tf, p[0], p[1] - p[0], ..., p[tf-1] - p[tf-2]
+// Mapperii scriu payload-urile in buffere de blocuri fixe, cate unul pentru
+// fiecare reducer, fara containere STL pe termen; reducerii doar sorteaza
+// chei catre aceste blocuri, iar IndexBuilder copiaza payload-urile, in
+// ordinea postarilor, in fisierul <index>.pos de langa indexul binar.
+// Costul fata de indexul doar cu documente: 1-5 octeti pe aparitie si 3-15
+// octeti pe pereche (termen, fisier) in mapperi, plus o cheie de 24 de
+// octeti pe pereche in reduceri (vezi position_bytes in --stats).
+
+// dimensiunea unui bloc din bufferele mapperilor
+const size_t POSITION_BLOCK_SIZE = 64 * 1024;
+
+// Buffer de octeti doar cu adaugare, in blocuri de POSITION_BLOCK_SIZE:
+// nu se realoca si nu copiaza la crestere, iar o inregistrare nu e
+// niciodata impartita intre doua blocuri (una mai mare decat un bloc
+// primeste un bloc propriu)
+class BlockBuffer {
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Block> blocks;
+    uint64_t allocated = 0;
+
+public:
+    // spatiu contiguu pentru cel mult max_bytes, confirmat apoi cu commit
+    uint8_t* reserve(size_t max_bytes) {
+        if(blocks.empty() || blocks.back().size - blocks.back().used < max_bytes) {
+            size_t size = std::max(POSITION_BLOCK_SIZE, max_bytes);
+            blocks.push_back({std::make_unique<uint8_t[]>(size), size, 0});
+            allocated += size;
+        }
+        return blocks.back().data.get() + blocks.back().used;
+    }
+
+    // end este sfarsitul octetilor scrisi dupa reserve
+    void commit(const uint8_t* end) {
+        blocks.back().used = static_cast<size_t>(end - blocks.back().data.get());
+    }
+
+    uint64_t allocatedBytes() const {
+        return allocated;
+    }
+
+    // callback(data, size) pentru fiecare bloc, in ordinea scrierii
+    template<class F>
+    void forEachBlock(F&& callback) const {
+        for(const Block& block : blocks) {
+            callback(block.data.get(), block.used);
+        }
+    }
+};
+
+// Pozitiile adunate de un mapper, impartite pe reduceri. Inregistrarea unei
+// perechi (termen, fisier) este: varint termen, varint fisier, varint
+// lungimea payload-ului, apoi payload-ul.
+class PositionCollector {
+private:
+    const Partitioner& partitioner;
+    std::vector<BlockBuffer> partitions;
+    std::vector<uint64_t> records; // inregistrarile fiecarei partitii
+    std::vector<uint32_t> first; // inceputul pozitiilor fiecarui termen
+    std::vector<uint32_t> next;
+    std::vector<uint32_t> sorted; // pozitiile fisierului, grupate pe termeni
+
+public:
+    PositionCollector(const Partitioner& partitioner, int num_reducers)
+        : partitioner(partitioner), partitions(num_reducers), records(num_reducers) {}
+
+    // adauga pozitiile unui fisier: terms sunt termenii lui distincti (ca in
+    // mapper), iar slots[p] este indicele din terms al cuvantului de pe
+    // pozitia p
+    void addFile(int file_id, const std::vector<std::pair<TermId, PrefixCell>>& terms,
+                 const std::vector<uint32_t>& slots) {
+        // sortare prin numarare dupa termen; pozitiile raman crescatoare
+        first.assign(terms.size() + 1, 0);
+        for(uint32_t slot : slots) first[slot + 1]++;
+        for(size_t s = 0; s < terms.size(); s++) first[s + 1] += first[s];
+        next.assign(first.begin(), first.end() - 1);
+        sorted.resize(slots.size());
+        for(uint32_t p = 0; p < slots.size(); p++) sorted[next[slots[p]]++] = p;
+
+        for(size_t s = 0; s < terms.size(); s++) {
+            const uint32_t* begin = sorted.data() + first[s];
+            const uint32_t* end = sorted.data() + first[s + 1];
+            uint32_t tf = static_cast<uint32_t>(end - begin);
+            size_t length = varintSize(tf);
+            uint32_t previous = 0;
+            for(const uint32_t* p = begin; p < end; p++) {
+                length += varintSize(*p - previous);
+                previous = *p;
+            }
+            int reducer = partitioner.reducerFor(terms[s].second);
+            BlockBuffer& buffer = partitions[reducer];
+            records[reducer]++;
+            uint8_t* out = buffer.reserve(15 + length);
+            out = writeVarint(out, terms[s].first);
+            out = writeVarint(out, static_cast<uint32_t>(file_id));
+            out = writeVarint(out, static_cast<uint32_t>(length));
+            out = writeVarint(out, tf);
+            previous = 0;
+            for(const uint32_t* p = begin; p < end; p++) {
+                out = writeVarint(out, *p - previous);
+                previous = *p;
+            }
+            buffer.commit(out);
+        }
+    }
+
+    const BlockBuffer& partition(int reducer) const {
+        return partitions[reducer];
+    }
+
+    uint64_t recordCount(int reducer) const {
+        return records[reducer];
+    }
+
+    uint64_t allocatedBytes() const {
+        uint64_t bytes = 0;
+        for(const auto& buffer : partitions) bytes += buffer.allocatedBytes();
+        return bytes;
+    }
+};
+
+// Pozitiile tuturor mapperilor, indexate la reduce: fiecare reducer isi
+// sorteaza cheile (termen, fisier) catre payload-urile din blocurile
+// mapperilor, care raman pe loc pana la scrierea indexului
+class PositionStore {
+private:
+    struct Key {
+        TermId term;
+        uint32_t file_id;
+        const uint8_t* payload;
+        uint64_t length;
+    };
+
+    const Partitioner& partitioner;
+    std::vector<std::unique_ptr<PositionCollector>> collectors;
+    std::vector<std::vector<Key>> tables; // cheile sortate ale fiecarui reducer
+
+public:
+    PositionStore(const Partitioner& partitioner, int num_mappers, int num_reducers)
+        : partitioner(partitioner), tables(num_reducers) {
+        for(int i = 0; i < num_mappers; i++) {
+            collectors.push_back(std::make_unique<PositionCollector>(partitioner, num_reducers));
+        }
+    }
+
+    PositionCollector& collector(int mapper) {
+        return *collectors[mapper];
+    }
+
+    // sorteaza cheile partitiei reducerului, dupa ce mapperii au terminat;
+    // intoarce memoria ocupata de chei
+    uint64_t buildTable(int reducer) {
+        std::vector<Key>& keys = tables[reducer];
+        uint64_t count = 0;
+        for(const auto& collector : collectors) count += collector->recordCount(reducer);
+        keys.reserve(count);
+        for(const auto& collector : collectors) {
+            collector->partition(reducer).forEachBlock([&keys](const uint8_t* p, size_t size) {
+                const uint8_t* end = p + size;
+                while(p < end) {
+                    Key key;
+                    key.term = readVarint(p, end);
+                    key.file_id = readVarint(p, end);
+                    key.length = readVarint(p, end);
+                    key.payload = p;
+                    p += key.length;
+                    keys.push_back(key);
+                }
+            });
+        }
+        std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+            return a.term != b.term ? a.term < b.term : a.file_id < b.file_id;
+        });
+        return keys.capacity() * sizeof(Key);
+    }
+
+    // adauga la out payload-urile termenului, in ordinea crescatoare a
+    // fisierelor (aceeasi cu a postarilor); word este sirul termenului
+    void append(TermId term, std::string_view word, std::vector<uint8_t>& out) const {
+        const std::vector<Key>& keys = tables[partitioner.reducerFor(prefixCell(word))];
+        auto it = std::lower_bound(keys.begin(), keys.end(), term, [](const Key& key, TermId value) {
+            return key.term < value;
+        });
+        for(; it != keys.end() && it->term == term; ++it) {
+            out.insert(out.end(), it->payload, it->payload + it->length);
+        }
+    }
+};
+
+// Fisierul <index>.pos. Structura:
+//  * PositionsHeader
+//  * tabela: num_terms x PositionsTermRecord, in ordinea termenilor din index
+//  * payload-urile fiecarui termen, concatenate in ordinea postarilor
+// Fisierul apartine unui singur index: index_size si num_terms trebuie sa
+// fie cele ale indexului de langa el.
+struct PositionsHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_terms;
+    uint64_t index_size; // file_size din IndexHeader
+    uint64_t data_offset;
+    uint64_t file_size;
+};
+
+struct PositionsTermRecord {
+    uint64_t offset; // in sectiunea de date
+    uint64_t bytes;
+};
+
+const char POSITIONS_MAGIC[8] = {'T', 'E', 'M', 'A', '1', 'P', 'O', 'S'};
+const uint32_t POSITIONS_VERSION = 1;
+
+inline std::string positionsPath(const std::string& index_path) {
+    return index_path + ".pos";
+}
+
+// Fisierul de pozitii incarcat prin mmap, ca IndexFile
+class PositionFile {
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    const PositionsHeader* header = nullptr;
+    const PositionsTermRecord* records = nullptr;
+    const uint8_t* data = nullptr;
+
+    void unmap() {
+        if(base != nullptr) {
+            munmap(const_cast<uint8_t*>(base), length);
+        }
+        base = nullptr;
+        length = 0;
+        header = nullptr;
+    }
+
+    bool validate(uint64_t index_size, uint32_t num_terms) const {
+        if(length < sizeof(PositionsHeader) ||
+           std::memcmp(header->magic, POSITIONS_MAGIC, sizeof(POSITIONS_MAGIC)) != 0 ||
+           header->version != POSITIONS_VERSION || header->file_size != length ||
+           header->index_size != index_size || header->num_terms != num_terms ||
+           header->data_offset != sizeof(PositionsHeader) + uint64_t(num_terms) * sizeof(PositionsTermRecord) ||
+           header->data_offset > length) {
+            return false;
+        }
+        uint64_t data_size = length - header->data_offset;
+        for(uint32_t i = 0; i < num_terms; i++) {
+            if(records[i].offset > data_size || records[i].bytes > data_size - records[i].offset) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    PositionFile() = default;
+    PositionFile(const PositionFile&) = delete;
+    PositionFile& operator=(const PositionFile&) = delete;
+
+    ~PositionFile() {
+        unmap();
+    }
+
+    // false daca fisierul lipseste sau nu apartine indexului dat
+    bool open(const std::string& path, uint64_t index_size, uint32_t num_terms) {
+        unmap();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return false;
+        }
+        struct stat st{};
+        void* mapped = MAP_FAILED;
+        if(fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(PositionsHeader))) {
+            mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if(mapped == MAP_FAILED) {
+            return false;
+        }
+        base = static_cast<const uint8_t*>(mapped);
+        length = st.st_size;
+        header = reinterpret_cast<const PositionsHeader*>(base);
+        records = reinterpret_cast<const PositionsTermRecord*>(base + sizeof(PositionsHeader));
+        if(!validate(index_size, num_terms)) {
+            unmap();
+            return false;
+        }
+        data = base + header->data_offset;
+        return true;
+    }
+
+    bool isOpen() const {
+        return header != nullptr;
+    }
+
+    // decodifica pozitiile termenului pentru doc_count fisiere: pozitiile
+    // fisierului i sunt positions[bounds[i], bounds[i + 1]), deci tf-ul lui
+    // este bounds[i + 1] - bounds[i]
+    void decode(uint32_t index, uint32_t doc_count,
+                std::vector<uint32_t>& bounds, std::vector<uint32_t>& positions) const {
+        const uint8_t* p = data + records[index].offset;
+        const uint8_t* end = p + records[index].bytes;
+        bounds.assign(1, 0);
+        positions.clear();
+        for(uint32_t doc = 0; doc < doc_count; doc++) {
+            uint32_t tf = p < end ? readVarint(p, end) : 0;
+            uint32_t position = 0;
+            for(uint32_t k = 0; k < tf && p < end; k++) {
+                position += readVarint(p, end);
+                positions.push_back(position);
+            }
+            bounds.push_back(static_cast<uint32_t>(positions.size()));
+        }
+    }
+};
+
+#endif // POSITIONS_H
@@ -0,0 +1,343 @@
+#ifndef POSTINGS_H
+#define POSTINGS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "term_dictionary.h"
+
+// Lista de fisiere (posting list) a unui cuvant, cu reprezentare adaptiva:
+//  * Inline - pana la INLINE_CAPACITY id-uri sortate, direct in obiect
+//  * Array  - vector sortat alocat separat, pentru termenii rari
+//  * Bitmap - bitmap dens indexat dupa id, pentru termenii frecventi
+// Trecerea Array -> Bitmap se face cand vectorul ar ocupa mai mult decat
+// bitmap-ul care acopera acelasi interval de id-uri (densitate > 1/32).
+// Densitatea se reverifica la fiecare crestere a bitmap-ului: daca un id
+// mare l-ar face mai scump decat vectorul, lista revine la Array.
+// Id-urile sunt mereu parcurse crescator, fara duplicate.
+class Postings {
+public:
+    static const uint32_t INLINE_CAPACITY = 4;
+
+private:
+    enum Kind : uint8_t { Inline, Array, Bitmap };
+
+    Kind kind = Inline;
+    uint32_t count = 0; // numarul de id-uri distincte
+    uint32_t capacity = 0; // elemente alocate (Array) sau cuvinte de 64 biti (Bitmap)
+    union {
+        uint32_t inline_ids[INLINE_CAPACITY];
+        uint32_t* array;
+        uint64_t* bitmap;
+    };
+
+    uint32_t* ids() {
+        return kind == Inline ? inline_ids : array;
+    }
+
+    const uint32_t* ids() const {
+        return kind == Inline ? inline_ids : array;
+    }
+
+    void release() {
+        if(kind == Array) delete[] array;
+        if(kind == Bitmap) delete[] bitmap;
+    }
+
+    // numarul de cuvinte de 64 biti necesare pentru a acoperi id-ul dat
+    static uint32_t wordsFor(uint32_t id) {
+        return id / 64 + 1;
+    }
+
+    // cuvintele de 64 biti ale unui bitmap care ar acoperi lista
+    uint32_t maxWords() const {
+        if(kind == Bitmap) return capacity;
+        return count ? wordsFor(ids()[count - 1]) : 0;
+    }
+
+    // false daca bitmap-ul extins pana la id ar fi prea rar (vezi demoteToArray)
+    bool ensureBitmapCapacity(uint32_t id, uint32_t new_count) {
+        uint32_t needed = wordsFor(id);
+        if(needed <= capacity) return true;
+        if(!denseEnough(new_count, needed)) return false;
+        // dublarea nu trece de dimensiunea vectorului echivalent
+        uint32_t limit = new_count * sizeof(uint32_t) / sizeof(uint64_t);
+        uint32_t new_capacity = std::max(needed, std::min(capacity * 2, limit));
+        uint64_t* bits = new uint64_t[new_capacity]();
+        std::memcpy(bits, bitmap, capacity * sizeof(uint64_t));
+        delete[] bitmap;
+        bitmap = bits;
+        capacity = new_capacity;
+        return true;
+    }
+
+    // converteste reprezentarea curenta (Inline / Array) in bitmap
+    void promoteToBitmap(uint32_t max_id) {
+        uint32_t words = wordsFor(max_id);
+        uint64_t* bits = new uint64_t[words]();
+        const uint32_t* src = ids();
+        for(uint32_t i = 0; i < count; i++) {
+            bits[src[i] / 64] |= uint64_t(1) << (src[i] % 64);
+        }
+        release();
+        kind = Bitmap;
+        bitmap = bits;
+        capacity = words;
+    }
+
+    // converteste bitmap-ul inapoi intr-un vector sortat, cu loc pentru
+    // inca un id
+    void demoteToArray() {
+        uint32_t new_capacity = std::max(INLINE_CAPACITY * 2, count * 2);
+        uint32_t* heap = new uint32_t[new_capacity];
+        uint32_t n = 0;
+        forEach([&](int id) { heap[n++] = static_cast<uint32_t>(id); });
+        delete[] bitmap;
+        kind = Array;
+        array = heap;
+        capacity = new_capacity;
+    }
+
+    // un bitmap de words cuvinte nu ocupa mai mult decat vectorul cu n id-uri
+    static bool denseEnough(uint32_t n, uint32_t words) {
+        return uint64_t(n) * sizeof(uint32_t) >= uint64_t(words) * sizeof(uint64_t);
+    }
+
+    // vectorul sortat ar ocupa mai mult decat bitmap-ul echivalent
+    bool shouldPromote(uint32_t max_id) const {
+        return uint64_t(count) * sizeof(uint32_t) > uint64_t(wordsFor(max_id)) * sizeof(uint64_t);
+    }
+
+    void copyFrom(const Postings& other) {
+        kind = other.kind;
+        count = other.count;
+        capacity = other.capacity;
+        if(kind == Inline) {
+            std::memcpy(inline_ids, other.inline_ids, sizeof(inline_ids));
+        } else if(kind == Array) {
+            array = new uint32_t[capacity];
+            std::memcpy(array, other.array, count * sizeof(uint32_t));
+        } else {
+            bitmap = new uint64_t[capacity];
+            std::memcpy(bitmap, other.bitmap, capacity * sizeof(uint64_t));
+        }
+    }
+
+    void stealFrom(Postings& other) {
+        kind = other.kind;
+        count = other.count;
+        capacity = other.capacity;
+        std::memcpy(inline_ids, other.inline_ids, sizeof(inline_ids));
+        other.kind = Inline;
+        other.count = 0;
+        other.capacity = 0;
+    }
+
+public:
+    Postings() : inline_ids{} {}
+
+    Postings(const Postings& other) {
+        copyFrom(other);
+    }
+
+    Postings(Postings&& other) noexcept {
+        stealFrom(other);
+    }
+
+    Postings& operator=(const Postings& other) {
+        if(this != &other) {
+            release();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    Postings& operator=(Postings&& other) noexcept {
+        if(this != &other) {
+            release();
+            stealFrom(other);
+        }
+        return *this;
+    }
+
+    ~Postings() {
+        release();
+    }
+
+    // numarul de fisiere distincte
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // adauga un id (ignorat daca exista deja)
+    void insert(int file_id) {
+        uint32_t id = static_cast<uint32_t>(file_id);
+        if(kind == Bitmap) {
+            if(ensureBitmapCapacity(id, count + 1)) {
+                uint64_t bit = uint64_t(1) << (id % 64);
+                if(!(bitmap[id / 64] & bit)) {
+                    bitmap[id / 64] |= bit;
+                    count++;
+                }
+                return;
+            }
+            // id-ul e dincolo de bitmap, deci nu exista deja si e cel mai mare
+            demoteToArray();
+            array[count++] = id;
+            return;
+        }
+
+        uint32_t* data = ids();
+        // cazul obisnuit: id-urile vin crescator
+        uint32_t* pos = (count == 0 || data[count - 1] < id)
+                            ? data + count
+                            : std::lower_bound(data, data + count, id);
+        if(pos != data + count && *pos == id) {
+            return;
+        }
+        uint32_t max_id = std::max(id, count ? data[count - 1] : 0u);
+
+        if(kind == Inline && count == INLINE_CAPACITY) {
+            if(shouldPromote(max_id)) {
+                promoteToBitmap(max_id);
+                insert(file_id);
+                return;
+            }
+            // Inline -> Array
+            size_t offset = pos - inline_ids;
+            uint32_t* heap = new uint32_t[INLINE_CAPACITY * 2];
+            std::memcpy(heap, inline_ids, count * sizeof(uint32_t));
+            kind = Array;
+            array = heap;
+            capacity = INLINE_CAPACITY * 2;
+            data = array;
+            pos = data + offset;
+        } else if(kind == Array && count == capacity) {
+            if(shouldPromote(max_id)) {
+                promoteToBitmap(max_id);
+                insert(file_id);
+                return;
+            }
+            size_t offset = pos - array;
+            uint32_t* heap = new uint32_t[capacity * 2];
+            std::memcpy(heap, array, count * sizeof(uint32_t));
+            delete[] array;
+            array = heap;
+            capacity *= 2;
+            data = array;
+            pos = data + offset;
+        }
+
+        std::memmove(pos + 1, pos, (data + count - pos) * sizeof(uint32_t));
+        *pos = id;
+        count++;
+    }
+
+    // reuniunea cu alta lista (folosita la interclasarea indexurilor partiale)
+    // Reuniunea pe cuvinte se face doar daca rezultatul ramane dens;
+    // altfel id-urile celeilalte liste se insereaza unul cate unul.
+    void unionWith(const Postings& other) {
+        if(other.kind == Bitmap && denseEnough(std::max(count, other.count),
+                                               std::max(maxWords(), other.capacity))) {
+            if(kind != Bitmap) {
+                promoteToBitmap(count ? ids()[count - 1] : 0);
+            }
+            ensureBitmapCapacity(other.capacity * 64 - 1, count + other.count);
+            uint32_t total = 0;
+            for(uint32_t w = 0; w < capacity; w++) {
+                if(w < other.capacity) bitmap[w] |= other.bitmap[w];
+                total += __builtin_popcountll(bitmap[w]);
+            }
+            count = total;
+            return;
+        }
+        other.forEach([this](int id) { insert(id); });
+    }
+
+    // parcurge id-urile crescator
+    template<class F>
+    void forEach(F&& callback) const {
+        if(kind == Bitmap) {
+            for(uint32_t w = 0; w < capacity; w++) {
+                uint64_t bits = bitmap[w];
+                while(bits) {
+                    callback(static_cast<int>(w * 64 + __builtin_ctzll(bits)));
+                    bits &= bits - 1;
+                }
+            }
+            return;
+        }
+        const uint32_t* data = ids();
+        for(uint32_t i = 0; i < count; i++) {
+            callback(static_cast<int>(data[i]));
+        }
+    }
+
+    // memoria ocupata in afara obiectului (pentru statistici)
+    size_t heapBytes() const {
+        if(kind == Array) return capacity * sizeof(uint32_t);
+        if(kind == Bitmap) return capacity * sizeof(uint64_t);
+        return 0;
+    }
+};
+
+// Codificarea varint (7 biti pe octet, bitul inalt = mai urmeaza) folosita
+// de postarile indexului binar, de run-urile varsate si de pozitii
+
+// numarul de octeti ai valorii codificate
+inline size_t varintSize(uint32_t value) {
+    size_t size = 1;
+    while(value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+// scrie valoarea la p (cel mult 5 octeti); intoarce sfarsitul ei
+inline uint8_t* writeVarint(uint8_t* p, uint32_t value) {
+    while(value >= 0x80) {
+        *p++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(value);
+    return p;
+}
+
+inline void appendVarint(std::vector<uint8_t>& out, uint32_t value) {
+    uint8_t bytes[5];
+    out.insert(out.end(), bytes, writeVarint(bytes, value));
+}
+
+// citeste un varint fara sa treaca de end
+inline uint32_t readVarint(const uint8_t*& p, const uint8_t* end) {
+    uint32_t value = 0;
+    for(int shift = 0; p < end && shift < 35; shift += 7) {
+        uint8_t byte = *p++;
+        value |= uint32_t(byte & 0x7f) << shift;
+        if(!(byte & 0x80)) break;
+    }
+    return value;
+}
+
+// O intrare din index: termenul si lista fisierelor in care apare
+using IndexEntry = std::pair<TermId, Postings>;
+
+// Termenul si numarul de fisiere al unei intrari; sortarea si scrierea
+// cuvintelor merg pe orice tip de intrare pentru care exista aceste functii
+inline TermId termOf(const IndexEntry& entry) {
+    return entry.first;
+}
+
+inline size_t filesOf(const IndexEntry& entry) {
+    return entry.second.size();
+}
+
+#endif // POSTINGS_H
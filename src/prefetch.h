@@ -0,0 +1,432 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+// linux/fs.h, inclus de io_uring.h, defineste macro-ul BLOCK_SIZE
+#undef BLOCK_SIZE
+
+#include "input_reader.h"
+#include "work_stealing.h"
+
+// Citirea in avans a fisierelor mapperilor (--prefetch). Fiecare mapper
+// tine in zbor urmatoarele `depth` fisiere din planificator, citite in
+// buffere refolosite, astfel incat tokenizarea lucreaza pe date deja in
+// memorie chiar si cu page cache-ul rece. Citirile se fac prin io_uring
+// (apeluri de sistem directe, fara liburing) sau, cand kernelul nu il
+// ofera, de un thread de I/O al mapperului cu pread.
+
+// fisierele mai mari (si bucatile fisierelor mari) se mapeaza ca inainte
+const uint64_t PREFETCH_MAX_FILE = 32 * 1024 * 1024;
+
+enum class PrefetchEngine {
+    Auto, // io_uring daca e disponibil, altfel pread
+    Uring,
+    Pread
+};
+
+// Un fisier in curs de citire (sau citit), cu buffer-ul lui refolosibil
+struct PrefetchSlot {
+    MapTask task;
+    std::unique_ptr<char[]> buffer;
+    size_t capacity = 0;
+    size_t size = 0; // octetii de citit (dimensiunea din fstat)
+    size_t done = 0; // octetii cititi pana acum
+    int fd = -1;
+    iovec iov{};
+    bool direct = false; // nu se citeste in avans, mapperul il mapeaza singur
+    bool failed = false;
+    bool ready = false;
+
+    void reserve(size_t bytes) {
+        if(bytes > capacity) {
+            buffer.reset(new char[bytes]);
+            capacity = bytes;
+        }
+    }
+
+    // deschide fisierul si afla dimensiunea; false daca nu mai e nimic de
+    // citit (fisier gol, esuat sau devenit direct)
+    bool openFile() {
+        fd = ::open(task.file_name.c_str(), O_RDONLY);
+        struct stat st{};
+        if(fd < 0 || fstat(fd, &st) != 0) {
+            failed = true;
+        } else if(!S_ISREG(st.st_mode) || static_cast<uint64_t>(st.st_size) > PREFETCH_MAX_FILE) {
+            direct = true;
+        } else {
+            size = static_cast<size_t>(st.st_size);
+            reserve(size);
+            if(size > 0) return true;
+        }
+        closeFile();
+        return false;
+    }
+
+    void closeFile() {
+        if(fd >= 0) ::close(fd);
+        fd = -1;
+    }
+};
+
+// Inel io_uring minimal: doar citiri READV si asteptarea terminarii lor
+class IoUring {
+private:
+    int fd = -1;
+    unsigned entries = 0;
+    unsigned to_submit = 0;
+    void* sq_ring = MAP_FAILED;
+    void* cq_ring = MAP_FAILED;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    static unsigned* field(void* ring, uint32_t offset) {
+        return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+    }
+
+public:
+    explicit IoUring(unsigned num_entries) {
+        io_uring_params params{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, num_entries, &params));
+        if(fd < 0) {
+            return;
+        }
+        entries = params.sq_entries;
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if(single) {
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        }
+        sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        cq_ring = single ? sq_ring
+                         : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if(sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+            release();
+            return;
+        }
+        sq_head = field(sq_ring, params.sq_off.head);
+        sq_tail = field(sq_ring, params.sq_off.tail);
+        sq_mask = field(sq_ring, params.sq_off.ring_mask);
+        sq_array = field(sq_ring, params.sq_off.array);
+        cq_head = field(cq_ring, params.cq_off.head);
+        cq_tail = field(cq_ring, params.cq_off.tail);
+        cq_mask = field(cq_ring, params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(cq_ring) + params.cq_off.cqes);
+    }
+
+    ~IoUring() {
+        release();
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool isOpen() const {
+        return fd >= 0;
+    }
+
+    void release() {
+        if(sqes != MAP_FAILED) munmap(sqes, sqes_size);
+        if(cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+        if(sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+        sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        sq_ring = cq_ring = MAP_FAILED;
+        if(fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    // pune in coada o citire; false daca inelul e plin
+    bool queueRead(int file, iovec* iov, uint64_t offset, uint64_t user_data) {
+        unsigned tail = *sq_tail;
+        if(tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= entries) {
+            return false;
+        }
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = file;
+        sqe.addr = reinterpret_cast<uint64_t>(iov);
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        to_submit++;
+        return true;
+    }
+
+    // trimite citirile din coada si, cu wait, asteapta cel putin o
+    // terminare; callback(user_data, res) pentru fiecare citire terminata
+    template<class F>
+    bool submit(bool wait, F&& callback) {
+        for(;;) {
+            long ret = syscall(__NR_io_uring_enter, fd, to_submit, wait ? 1 : 0,
+                               wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if(ret >= 0) {
+                to_submit -= static_cast<unsigned>(ret);
+                break;
+            }
+            if(errno != EINTR) {
+                return false;
+            }
+        }
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for(; head != tail; head++) {
+            const io_uring_cqe& cqe = cqes[head & *cq_mask];
+            callback(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+
+// Sursa de fisiere a unui mapper: cu depth = 0 ia sarcinile direct de la
+// planificator si mapeaza fisierele (comportamentul obisnuit), altfel le
+// citeste in avans. Datele fisierului curent raman valide pana la next().
+class MapperInput {
+private:
+    WorkStealingScheduler& scheduler;
+    int worker;
+    size_t depth;
+    bool exhausted = false;
+
+    std::deque<std::unique_ptr<PrefetchSlot>> pending; // in ordinea sarcinilor
+    std::vector<std::unique_ptr<PrefetchSlot>> free_slots; // cu buffere refolosibile
+    std::unique_ptr<PrefetchSlot> current;
+    std::unique_ptr<MappedFile> mapped; // fisierul curent, cand nu e citit in avans
+    std::string file_name; // fisierul sarcinii curente
+
+    std::unique_ptr<IoUring> ring;
+
+    // fallback-ul fara io_uring: threadul de I/O al mapperului
+    std::thread io_thread;
+    std::mutex io_mutex;
+    std::condition_variable io_cond; // sloturi noi pentru thread / sloturi gata
+    std::deque<PrefetchSlot*> io_queue;
+    bool io_stop = false;
+
+    void ioLoop() {
+        std::unique_lock<std::mutex> lock(io_mutex);
+        for(;;) {
+            io_cond.wait(lock, [this] { return io_stop || !io_queue.empty(); });
+            if(io_queue.empty()) {
+                return;
+            }
+            PrefetchSlot* slot = io_queue.front();
+            io_queue.pop_front();
+            lock.unlock();
+            if(slot->openFile()) {
+                while(slot->done < slot->size) {
+                    ssize_t n = pread(slot->fd, slot->buffer.get() + slot->done, slot->size - slot->done, slot->done);
+                    if(n < 0 && errno == EINTR) continue;
+                    if(n < 0) slot->failed = true;
+                    if(n <= 0) break; // eroare sau fisier trunchiat intre timp
+                    slot->done += static_cast<size_t>(n);
+                }
+                slot->size = slot->done;
+                slot->closeFile();
+            }
+            lock.lock();
+            slot->ready = true;
+            io_cond.notify_all();
+        }
+    }
+
+    // trimite (din nou) restul citirii unui slot
+    void queueRest(PrefetchSlot* slot) {
+        slot->iov.iov_base = slot->buffer.get() + slot->done;
+        slot->iov.iov_len = slot->size - slot->done;
+        ring->queueRead(slot->fd, &slot->iov, slot->done, reinterpret_cast<uint64_t>(slot));
+    }
+
+    // rezultatul unei citiri io_uring
+    void complete(uint64_t user_data, int res) {
+        PrefetchSlot* slot = reinterpret_cast<PrefetchSlot*>(user_data);
+        if(res == -EINTR || res == -EAGAIN) {
+            queueRest(slot);
+            return;
+        }
+        if(res > 0) {
+            slot->done += static_cast<size_t>(res);
+            if(slot->done < slot->size) {
+                queueRest(slot);
+                return;
+            }
+        }
+        slot->failed = res < 0;
+        slot->size = slot->done;
+        slot->closeFile();
+        slot->ready = true;
+    }
+
+    // incepe citirea unui fisier
+    void start(PrefetchSlot* slot) {
+        if(slot->task.chunked != nullptr || slot->task.size > PREFETCH_MAX_FILE) {
+            slot->direct = true;
+            slot->ready = true;
+        } else if(ring != nullptr) {
+            if(slot->openFile()) {
+                queueRest(slot);
+            } else {
+                slot->ready = true;
+            }
+        } else {
+            std::lock_guard<std::mutex> lock(io_mutex);
+            io_queue.push_back(slot);
+            io_cond.notify_all();
+        }
+    }
+
+    // completeaza fereastra de citiri in avans
+    void refill() {
+        while(!exhausted && pending.size() < depth) {
+            std::unique_ptr<PrefetchSlot> slot;
+            if(free_slots.empty()) {
+                slot = std::make_unique<PrefetchSlot>();
+            } else {
+                slot = std::move(free_slots.back());
+                free_slots.pop_back();
+            }
+            if(!scheduler.next(worker, slot->task)) {
+                exhausted = true;
+                free_slots.push_back(std::move(slot));
+                break;
+            }
+            slot->size = slot->done = 0;
+            slot->direct = slot->failed = slot->ready = false;
+            start(slot.get());
+            pending.push_back(std::move(slot));
+        }
+        if(ring != nullptr) {
+            ring->submit(false, [this](uint64_t user_data, int res) { complete(user_data, res); });
+        }
+    }
+
+    void waitReady(PrefetchSlot* slot) {
+        if(ring != nullptr) {
+            while(!slot->ready) {
+                if(!ring->submit(true, [this](uint64_t user_data, int res) { complete(user_data, res); })) {
+                    // inelul nu mai raspunde: fisierul se citeste direct
+                    slot->closeFile();
+                    slot->direct = true;
+                    slot->ready = true;
+                }
+            }
+            return;
+        }
+        std::unique_lock<std::mutex> lock(io_mutex);
+        io_cond.wait(lock, [slot] { return slot->ready; });
+    }
+
+public:
+    MapperInput(WorkStealingScheduler& scheduler, int worker, int depth, PrefetchEngine engine)
+        : scheduler(scheduler), worker(worker), depth(static_cast<size_t>(depth)) {
+        if(depth <= 0) {
+            return;
+        }
+        if(engine != PrefetchEngine::Pread) {
+            ring = std::make_unique<IoUring>(static_cast<unsigned>(depth) + 1);
+            if(!ring->isOpen()) {
+                ring.reset();
+            }
+        }
+        if(ring == nullptr) {
+            io_thread = std::thread(&MapperInput::ioLoop, this);
+        }
+    }
+
+    ~MapperInput() {
+        // citirile inca in zbor scriu in buffere: se asteapta terminarea lor
+        for(auto& slot : pending) {
+            waitReady(slot.get());
+        }
+        if(io_thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(io_mutex);
+                io_stop = true;
+            }
+            io_cond.notify_all();
+            io_thread.join();
+        }
+    }
+
+    MapperInput(const MapperInput&) = delete;
+    MapperInput& operator=(const MapperInput&) = delete;
+
+    // true daca citirile se fac prin io_uring
+    bool usesUring() const {
+        return ring != nullptr;
+    }
+
+    // urmatoarea sarcina; false cand nu mai e nimic de facut
+    bool next(MapTask& task) {
+        mapped.reset();
+        if(depth == 0) {
+            if(!scheduler.next(worker, task)) {
+                return false;
+            }
+            file_name = task.file_name;
+            return true;
+        }
+        if(current != nullptr) {
+            free_slots.push_back(std::move(current));
+        }
+        refill();
+        if(pending.empty()) {
+            return false;
+        }
+        current = std::move(pending.front());
+        pending.pop_front();
+        refill();
+        waitReady(current.get());
+        task = current->task;
+        file_name = task.file_name;
+        return true;
+    }
+
+    // continutul sarcinii curente; false daca fisierul nu s-a putut citi
+    bool open(std::string_view& text) {
+        if(current != nullptr && !current->direct) {
+            text = std::string_view(current->buffer.get(), current->size);
+            return !current->failed;
+        }
+        mapped = std::make_unique<MappedFile>(file_name);
+        text = mapped->data();
+        return mapped->isOpen();
+    }
+};
+
+#endif // PREFETCH_H
@@ -0,0 +1,206 @@
+#ifndef PROCESS_SHUFFLE_H
+#define PROCESS_SHUFFLE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "partial_index.h"
+#include "spill.h"
+#include "term_dictionary.h"
+
+// Indexarea cu procese (--shuffle=process). Coordonatorul creeaza cate un
+// memfd pentru fiecare mapper, apoi porneste mapperii cu fork(): fiecare
+// isi mapeaza shard-ul de fisiere cu propriul dictionar si propriul index
+// partial, deci fara lock-uri sau alocator comune cu ceilalti, si isi scrie
+// run-urile in memfd. Cum TermId-urile sunt locale fiecarui proces, run-urile
+// contin sirurile termenilor. Structura unui segment:
+//  * partitiile 0..R-1, una dupa alta; in fiecare, pentru fiecare termen:
+//    varint(lungimea sirului), sirul, varint(numarul de fisiere), apoi
+//    id-urile crescatoare codificate ca diferente (ca in run-urile varsate)
+//  * la sfarsit, R + 1 offset-uri pe 64 de biti: inceputul fiecarei
+//    partitii si sfarsitul ultimei
+// Dupa mapperi, coordonatorul porneste reducerii, tot cu fork(); reducerul r
+// citeste partitia r din toate segmentele, mapate direct din memfd.
+
+// Un segment de memorie partajata (memfd), mostenit de procesele copil
+class ShuffleSegment {
+private:
+    int fd = -1;
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+
+public:
+    explicit ShuffleSegment(const std::string& name) {
+        fd = memfd_create(name.c_str(), MFD_CLOEXEC);
+    }
+
+    ~ShuffleSegment() {
+        if(base != nullptr) munmap(const_cast<uint8_t*>(base), length);
+        if(fd >= 0) ::close(fd);
+    }
+
+    ShuffleSegment(const ShuffleSegment&) = delete;
+    ShuffleSegment& operator=(const ShuffleSegment&) = delete;
+
+    bool isOpen() const {
+        return fd >= 0;
+    }
+
+    int descriptor() const {
+        return fd;
+    }
+
+    // mapeaza continutul scris pana acum (de alt proces); gol daca nu s-a
+    // scris nimic
+    std::string_view map() {
+        if(base == nullptr) {
+            struct stat st{};
+            if(fstat(fd, &st) != 0 || st.st_size == 0) return {};
+            void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if(mapped == MAP_FAILED) return {};
+            base = static_cast<const uint8_t*>(mapped);
+            length = st.st_size;
+        }
+        return std::string_view(reinterpret_cast<const char*>(base), length);
+    }
+};
+
+// Scrie run-urile sortate ale indexului partial (dupa seal) in segment
+inline bool writeShuffleRuns(const ShuffleSegment& segment, PartialIndex& partial,
+                             const TermDictionary& dict, int partitions) {
+    SpillWriter writer(dup(segment.descriptor()));
+    std::vector<uint64_t> offsets;
+    for(int p = 0; p < partitions; p++) {
+        offsets.push_back(writer.offset());
+        for(const auto& entry : partial.run(p)) {
+            std::string_view word = dict.resolve(entry.first);
+            appendVarint(writer.buffer, static_cast<uint32_t>(word.size()));
+            writer.buffer.insert(writer.buffer.end(), word.begin(), word.end());
+            appendVarint(writer.buffer, static_cast<uint32_t>(entry.second.size()));
+            uint32_t previous = 0;
+            entry.second.forEach([&](int file_id) {
+                appendVarint(writer.buffer, static_cast<uint32_t>(file_id) - previous);
+                previous = static_cast<uint32_t>(file_id);
+            });
+            writer.maybeFlush();
+        }
+    }
+    offsets.push_back(writer.offset());
+    const uint8_t* table = reinterpret_cast<const uint8_t*>(offsets.data());
+    writer.buffer.insert(writer.buffer.end(), table, table + offsets.size() * sizeof(uint64_t));
+    return writer.close();
+}
+
+// Parcurge termenii partitiei dintr-un segment mapat:
+// callback(word, ids), cu id-urile crescatoare. false daca segmentul e invalid.
+template<class F>
+bool forEachShuffledTerm(std::string_view segment, int partition, int partitions,
+                         std::vector<uint32_t>& ids, F&& callback) {
+    size_t table_size = (partitions + 1) * sizeof(uint64_t);
+    if(segment.size() < table_size) {
+        return false;
+    }
+    std::vector<uint64_t> offsets(partitions + 1);
+    std::memcpy(offsets.data(), segment.data() + segment.size() - table_size, table_size);
+    uint64_t data_size = segment.size() - table_size;
+    if(offsets[partition] > offsets[partition + 1] || offsets[partition + 1] > data_size) {
+        return false;
+    }
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(segment.data()) + offsets[partition];
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(segment.data()) + offsets[partition + 1];
+    while(p < end) {
+        uint32_t size = readVarint(p, end);
+        if(size > static_cast<size_t>(end - p)) {
+            return false;
+        }
+        std::string_view word(reinterpret_cast<const char*>(p), size);
+        p += size;
+        uint32_t count = readVarint(p, end);
+        ids.clear();
+        uint32_t id = 0;
+        for(uint32_t i = 0; i < count && p < end; i++) {
+            id += readVarint(p, end);
+            ids.push_back(id);
+        }
+        callback(word, ids);
+    }
+    return true;
+}
+
+// Un vector de T in memorie anonima partajata, vizibil si coordonatorului
+// dupa ce procesele copil scriu in el (statisticile cu --stats)
+template<class T>
+class SharedArray {
+private:
+    T* data = nullptr;
+    size_t count = 0;
+
+public:
+    explicit SharedArray(size_t n) : count(n) {
+        if(n == 0) return;
+        void* mapped = mmap(nullptr, n * sizeof(T), PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if(mapped == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        data = static_cast<T*>(mapped);
+        for(size_t i = 0; i < n; i++) new(data + i) T();
+    }
+
+    ~SharedArray() {
+        if(data != nullptr) munmap(data, count * sizeof(T));
+    }
+
+    SharedArray(const SharedArray&) = delete;
+    SharedArray& operator=(const SharedArray&) = delete;
+
+    T& operator[](size_t i) {
+        return data[i];
+    }
+};
+
+// Ruleaza function() intr-un proces copil, care iese cu EXIT_SUCCESS daca
+// function intoarce true (fara destructorii si handler-ele atexit ale
+// coordonatorului). Intoarce pid-ul copilului, sau -1.
+template<class F>
+pid_t forkWorker(F&& function) {
+    pid_t pid = fork();
+    if(pid == 0) {
+        bool ok = false;
+        try {
+            ok = function();
+        } catch(const std::exception& e) {
+            std::cerr << "Eroare in procesul " << getpid() << ": " << e.what() << std::endl;
+        }
+        _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    return pid;
+}
+
+// Asteapta toate procesele pornite; false daca vreunul n-a pornit sau a
+// esuat. what numeste procesele in mesajul de eroare ("mapper", "reducer").
+inline bool waitWorkers(const std::vector<pid_t>& pids, const char* what) {
+    bool ok = true;
+    for(size_t i = 0; i < pids.size(); i++) {
+        int status = 0;
+        if(pids[i] < 0 || waitpid(pids[i], &status, 0) != pids[i] ||
+           !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            std::cerr << "Procesul " << what << " " << i << " a esuat" << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+#endif // PROCESS_SHUFFLE_H
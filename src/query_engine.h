@@ -0,0 +1,481 @@
+#ifndef QUERY_ENGINE_H
+#define QUERY_ENGINE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "index_file.h"
+#include "tokenizer.h"
+
+// Operatii pe liste sortate de id-uri (postari decodificate)
+namespace postings_ops {
+
+// cauta exponential (galloping) prima pozitie >= value, incepand de la from
+inline size_t gallop(const std::vector<uint32_t>& v, size_t from, uint32_t value) {
+    size_t step = 1, low = from, high = from;
+    while(high < v.size() && v[high] < value) {
+        low = high + 1;
+        high += step;
+        step *= 2;
+    }
+    return std::lower_bound(v.begin() + low, v.begin() + std::min(high, v.size()), value) - v.begin();
+}
+
+// intersectie cand o lista e mult mai scurta: fiecare element al listei
+// scurte se cauta prin galloping in cea lunga
+inline void intersectGallop(const std::vector<uint32_t>& small, const std::vector<uint32_t>& large,
+                            std::vector<uint32_t>& out) {
+    size_t pos = 0;
+    for(uint32_t value : small) {
+        pos = gallop(large, pos, value);
+        if(pos == large.size()) break;
+        if(large[pos] == value) out.push_back(value);
+    }
+}
+
+// intersectie prin interclasare, cu blocuri de 4 x 4 comparate cu SSE2
+inline void intersectMerge(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                           std::vector<uint32_t>& out) {
+    size_t i = 0, j = 0;
+#ifdef __SSE2__
+    // fiecare element din blocul lui a se compara cu toate cele 4 rotatii
+    // ale blocului din b; avanseaza blocul (sau blocurile) cu maximul mai mic
+    while(i + 4 <= a.size() && j + 4 <= b.size()) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + j));
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                         _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        while(mask) {
+            out.push_back(a[i + __builtin_ctz(mask)]);
+            mask &= mask - 1;
+        }
+        uint32_t a_max = a[i + 3], b_max = b[j + 3];
+        if(a_max <= b_max) i += 4;
+        if(b_max <= a_max) j += 4;
+    }
+#endif
+    while(i < a.size() && j < b.size()) {
+        if(a[i] < b[j]) {
+            i++;
+        } else if(b[j] < a[i]) {
+            j++;
+        } else {
+            out.push_back(a[i]);
+            i++;
+            j++;
+        }
+    }
+}
+
+inline void intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                      std::vector<uint32_t>& out) {
+    out.clear();
+    const std::vector<uint32_t>& small = a.size() <= b.size() ? a : b;
+    const std::vector<uint32_t>& large = a.size() <= b.size() ? b : a;
+    // pragul de la care cautarea binara bate interclasarea
+    if(small.size() * 32 < large.size()) {
+        intersectGallop(small, large, out);
+    } else {
+        intersectMerge(small, large, out);
+    }
+}
+
+inline void unite(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                  std::vector<uint32_t>& out) {
+    out.clear();
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+}
+
+// a fara elementele din b
+inline void subtract(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b,
+                     std::vector<uint32_t>& out) {
+    out.clear();
+    size_t j = 0;
+    for(uint32_t value : a) {
+        if(b.size() * 32 < a.size()) {
+            j = std::lower_bound(b.begin() + j, b.end(), value) - b.begin();
+        } else {
+            while(j < b.size() && b[j] < value) j++;
+        }
+        if(j == b.size() || b[j] != value) out.push_back(value);
+    }
+}
+
+} // namespace postings_ops
+
+// Evaluarea interogarilor peste un index binar (IndexFile). Sintaxa:
+//   query  := ['RANK'] expr
+//   expr   := and ('OR' and)*
+//   and    := unary (['AND'] unary)*     (termenii alaturati inseamna AND)
+//   unary  := 'NOT' unary | '(' expr ')' | fraza | cuvant
+//   fraza  := '"' cuvinte '"' ['~' k]
+// Cuvintele se normalizeaza ca la indexare. In interiorul unui AND listele
+// se intersecteaza de la cea mai scurta, iar termenii negati se scad din
+// rezultat; complementul (fata de 1..numFiles) se calculeaza doar pentru un
+// NOT izolat.
+// Frazele si RANK cer pozitiile termenilor (index construit cu --positions):
+// o fraza potriveste cuvintele in ordine, cu cel mult k cuvinte intre doua
+// consecutive (k = 0: cuvinte alaturate), iar RANK ordoneaza rezultatul
+// descrescator dupa scorul tf-idf al cuvintelor nenegate din interogare,
+// suma de (1 + ln tf) * ln(1 + N / df).
+// Parantezele si NOT-urile imbricate sunt limitate la MAX_DEPTH niveluri,
+// ca parsarea si evaluarea recursive sa nu depaseasca stiva.
+class QueryEngine {
+public:
+    static const int MAX_DEPTH = 256;
+
+private:
+    struct Node {
+        enum Kind { Term, And, Or, Not, Phrase } kind;
+        std::string word; // Term
+        std::vector<std::string> words; // Phrase
+        uint32_t slop = 0; // Phrase: cuvintele permise intre doi termeni
+        std::vector<std::unique_ptr<Node>> children;
+    };
+
+    // postarile unui termen, cu pozitiile din fiecare fisier
+    struct TermPositions {
+        std::vector<uint32_t> docs;
+        std::vector<uint32_t> bounds; // pozitiile lui docs[i]: [bounds[i], bounds[i + 1])
+        std::vector<uint32_t> positions;
+    };
+
+    const IndexFile& index;
+
+    // --- parser ---
+    struct Parser {
+        std::vector<std::string> tokens;
+        size_t pos = 0;
+        int depth = 0; // '(' si NOT deschise
+
+        // frazele devin un singur token, '"' urmat de textul lor
+        explicit Parser(std::string_view query) {
+            std::string current;
+            for(size_t i = 0; i < query.size(); i++) {
+                char c = query[i];
+                if(c == '"') {
+                    size_t close = query.find('"', i + 1);
+                    if(close == std::string_view::npos) {
+                        throw std::invalid_argument("Interogare invalida: lipseste '\"'");
+                    }
+                    if(!current.empty()) tokens.push_back(std::move(current));
+                    current.clear();
+                    tokens.push_back(std::string(query.substr(i, close - i)));
+                    i = close;
+                } else if(c == '(' || c == ')' || isAsciiSpace(static_cast<unsigned char>(c))) {
+                    if(!current.empty()) tokens.push_back(std::move(current));
+                    current.clear();
+                    if(c != '(' && c != ')') continue;
+                    tokens.push_back(std::string(1, c));
+                } else {
+                    current += c;
+                }
+            }
+            if(!current.empty()) tokens.push_back(std::move(current));
+        }
+
+        bool peek(const char* token) const {
+            return pos < tokens.size() && tokens[pos] == token;
+        }
+
+        std::unique_ptr<Node> parseExpr() {
+            auto left = parseAnd();
+            while(peek("OR")) {
+                pos++;
+                left = combine(Node::Or, std::move(left), parseAnd());
+            }
+            return left;
+        }
+
+        std::unique_ptr<Node> parseAnd() {
+            auto left = parseUnary();
+            while(pos < tokens.size() && !peek("OR") && !peek(")")) {
+                if(peek("AND")) pos++;
+                left = combine(Node::And, std::move(left), parseUnary());
+            }
+            return left;
+        }
+
+        std::unique_ptr<Node> parseUnary() {
+            if(pos == tokens.size()) {
+                throw std::invalid_argument("Interogare invalida: lipseste un termen");
+            }
+            const std::string& token = tokens[pos++];
+            if(token == "NOT" || token == "(") {
+                if(++depth > MAX_DEPTH) {
+                    throw std::invalid_argument("Interogare invalida: imbricare prea adanca");
+                }
+            }
+            if(token == "NOT") {
+                auto node = std::make_unique<Node>();
+                node->kind = Node::Not;
+                node->children.push_back(parseUnary());
+                depth--;
+                return node;
+            }
+            if(token == "(") {
+                auto node = parseExpr();
+                if(!peek(")")) {
+                    throw std::invalid_argument("Interogare invalida: lipseste ')'");
+                }
+                pos++;
+                depth--;
+                return node;
+            }
+            if(token == ")" || token == "AND" || token == "OR") {
+                throw std::invalid_argument("Interogare invalida: '" + token + "' neasteptat");
+            }
+            if(token[0] == '"') {
+                return parsePhrase(token);
+            }
+            auto node = std::make_unique<Node>();
+            node->kind = Node::Term;
+            normalizeWord(token, node->word);
+            return node;
+        }
+
+        // cuvintele frazei se tokenizeaza ca textul indexat, deci pozitiile
+        // lor se potrivesc cu cele din fisiere; "~k" imediat dupa ghilimele
+        // da distanta maxima
+        std::unique_ptr<Node> parsePhrase(const std::string& token) {
+            auto node = std::make_unique<Node>();
+            node->kind = Node::Phrase;
+            forEachNormalizedWord(std::string_view(token).substr(1), [&node](std::string_view word) {
+                node->words.emplace_back(word);
+            });
+            if(pos < tokens.size() && tokens[pos][0] == '~') {
+                const std::string& slop = tokens[pos++];
+                if(slop.size() < 2 || slop.size() > 6 ||
+                   slop.find_first_not_of("0123456789", 1) != std::string::npos) {
+                    throw std::invalid_argument("Interogare invalida: distanta '" + slop + "'");
+                }
+                node->slop = static_cast<uint32_t>(std::stoul(slop.substr(1)));
+            }
+            return node;
+        }
+
+        // a OP b, aplatizat daca a e deja un nod OP
+        static std::unique_ptr<Node> combine(Node::Kind kind, std::unique_ptr<Node> a, std::unique_ptr<Node> b) {
+            if(a->kind != kind) {
+                auto node = std::make_unique<Node>();
+                node->kind = kind;
+                node->children.push_back(std::move(a));
+                a = std::move(node);
+            }
+            a->children.push_back(std::move(b));
+            return a;
+        }
+    };
+
+    // --- evaluare ---
+    void evaluate(const Node& node, std::vector<uint32_t>& out) const {
+        using namespace postings_ops;
+        std::vector<uint32_t> tmp, other;
+        switch(node.kind) {
+        case Node::Term: {
+            int64_t term = node.word.empty() ? -1 : index.find(node.word);
+            out.clear();
+            if(term >= 0) index.postingsOf(static_cast<uint32_t>(term), out);
+            return;
+        }
+        case Node::Phrase:
+            evaluatePhrase(node, out);
+            return;
+        case Node::Not:
+            evaluate(*node.children[0], tmp);
+            universe(other);
+            subtract(other, tmp, out);
+            return;
+        case Node::Or:
+            evaluate(*node.children[0], out);
+            for(size_t i = 1; i < node.children.size(); i++) {
+                evaluate(*node.children[i], other);
+                unite(out, other, tmp);
+                out.swap(tmp);
+            }
+            return;
+        case Node::And: {
+            std::vector<std::vector<uint32_t>> positive, negative;
+            for(const auto& child : node.children) {
+                bool negated = child->kind == Node::Not;
+                auto& lists = negated ? negative : positive;
+                lists.emplace_back();
+                evaluate(negated ? *child->children[0] : *child, lists.back());
+            }
+            if(positive.empty()) {
+                universe(out);
+            } else {
+                std::sort(positive.begin(), positive.end(), [](const auto& a, const auto& b) {
+                    return a.size() < b.size();
+                });
+                out.swap(positive[0]);
+                for(size_t i = 1; i < positive.size() && !out.empty(); i++) {
+                    intersect(out, positive[i], tmp);
+                    out.swap(tmp);
+                }
+            }
+            for(const auto& excluded : negative) {
+                subtract(out, excluded, tmp);
+                out.swap(tmp);
+            }
+            return;
+        }
+        }
+    }
+
+    void universe(std::vector<uint32_t>& out) const {
+        out.resize(index.numFiles());
+        for(uint32_t i = 0; i < out.size(); i++) out[i] = i + 1;
+    }
+
+    void requirePositions() const {
+        if(!index.hasPositions()) {
+            throw std::invalid_argument("Interogare invalida: indexul nu are pozitii (--positions)");
+        }
+    }
+
+    // false daca termenul nu exista in index
+    bool loadPositions(const std::string& word, TermPositions& term) const {
+        int64_t found = word.empty() ? -1 : index.find(word);
+        if(found < 0) return false;
+        index.postingsOf(static_cast<uint32_t>(found), term.docs);
+        index.positionsOf(static_cast<uint32_t>(found), term.bounds, term.positions);
+        return true;
+    }
+
+    // exista p[0] < p[1] < ... cu p[i] din lists[i] si p[i] - p[i-1] <= slop + 1;
+    // pentru fiecare inceput se alege cea mai mica pozitie urmatoare, care
+    // lasa cel mai mult loc termenilor de dupa
+    static bool chainMatches(const std::vector<std::pair<const uint32_t*, const uint32_t*>>& lists,
+                             uint32_t slop) {
+        for(const uint32_t* start = lists[0].first; start < lists[0].second; start++) {
+            uint32_t current = *start;
+            bool matched = true;
+            for(size_t k = 1; k < lists.size() && matched; k++) {
+                const uint32_t* next = std::upper_bound(lists[k].first, lists[k].second, current);
+                matched = next < lists[k].second && *next - current <= slop + 1;
+                if(matched) current = *next;
+            }
+            if(matched) return true;
+        }
+        return false;
+    }
+
+    void evaluatePhrase(const Node& node, std::vector<uint32_t>& out) const {
+        requirePositions();
+        out.clear();
+        if(node.words.empty()) return;
+        std::vector<TermPositions> terms(node.words.size());
+        for(size_t k = 0; k < terms.size(); k++) {
+            if(!loadPositions(node.words[k], terms[k])) return;
+        }
+        // fisierele care contin toate cuvintele, apoi verificarea pozitiilor
+        std::vector<uint32_t> candidates = terms[0].docs, tmp;
+        for(size_t k = 1; k < terms.size() && !candidates.empty(); k++) {
+            postings_ops::intersect(candidates, terms[k].docs, tmp);
+            candidates.swap(tmp);
+        }
+        std::vector<size_t> cursor(terms.size(), 0);
+        std::vector<std::pair<const uint32_t*, const uint32_t*>> lists(terms.size());
+        for(uint32_t doc : candidates) {
+            for(size_t k = 0; k < terms.size(); k++) {
+                const TermPositions& term = terms[k];
+                cursor[k] = postings_ops::gallop(term.docs, cursor[k], doc);
+                lists[k] = {term.positions.data() + term.bounds[cursor[k]],
+                            term.positions.data() + term.bounds[cursor[k] + 1]};
+            }
+            if(chainMatches(lists, node.slop)) out.push_back(doc);
+        }
+    }
+
+    // cuvintele nenegate ale interogarii, pentru RANK
+    static void scoringWords(const Node& node, std::vector<std::string>& words) {
+        switch(node.kind) {
+        case Node::Term:
+            if(!node.word.empty()) words.push_back(node.word);
+            return;
+        case Node::Phrase:
+            words.insert(words.end(), node.words.begin(), node.words.end());
+            return;
+        case Node::Not:
+            return;
+        default:
+            for(const auto& child : node.children) scoringWords(*child, words);
+        }
+    }
+
+    // reordoneaza ids (crescatoare) descrescator dupa scorul tf-idf; la
+    // scor egal ramane ordinea id-urilor
+    void rank(const Node& root, std::vector<uint32_t>& ids) const {
+        std::vector<std::string> words;
+        scoringWords(root, words);
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+
+        std::vector<double> scores(ids.size(), 0.0);
+        TermPositions term;
+        double num_files = index.numFiles();
+        for(const auto& word : words) {
+            if(!loadPositions(word, term)) continue;
+            double idf = std::log(1.0 + num_files / term.docs.size());
+            size_t j = 0;
+            for(size_t i = 0; i < ids.size(); i++) {
+                j = postings_ops::gallop(term.docs, j, ids[i]);
+                if(j == term.docs.size()) break;
+                if(term.docs[j] != ids[i]) continue;
+                uint32_t tf = term.bounds[j + 1] - term.bounds[j];
+                if(tf > 0) scores[i] += (1.0 + std::log(double(tf))) * idf;
+            }
+        }
+
+        std::vector<uint32_t> order(ids.size());
+        for(uint32_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&scores](uint32_t a, uint32_t b) {
+            return scores[a] > scores[b];
+        });
+        std::vector<uint32_t> ranked(ids.size());
+        for(size_t i = 0; i < order.size(); i++) ranked[i] = ids[order[i]];
+        ids.swap(ranked);
+    }
+
+public:
+    explicit QueryEngine(const IndexFile& file) : index(file) {}
+
+    // evalueaza interogarea; arunca std::invalid_argument la o sintaxa gresita
+    void run(std::string_view query, std::vector<uint32_t>& out) const {
+        Parser parser(query);
+        bool ranked = parser.peek("RANK");
+        if(ranked) {
+            requirePositions();
+            parser.pos++;
+        }
+        if(parser.pos == parser.tokens.size()) {
+            throw std::invalid_argument("Interogare invalida: interogare goala");
+        }
+        auto root = parser.parseExpr();
+        if(parser.pos != parser.tokens.size()) {
+            throw std::invalid_argument("Interogare invalida: '" + parser.tokens[parser.pos] + "' neasteptat");
+        }
+        evaluate(*root, out);
+        if(ranked) {
+            rank(*root, out);
+        }
+    }
+};
+
+#endif // QUERY_ENGINE_H
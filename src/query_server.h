@@ -0,0 +1,228 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "query_engine.h"
+
+// Protocolul serverului de interogari, pe un socket Unix (SOCK_STREAM):
+// clientul trimite cate o interogare pe linie, iar serverul raspunde cu o
+// linie "<numar>:<id> <id> ...", sau "ERR <mesaj>" pentru o interogare
+// invalida. O conexiune poate trimite oricate interogari; una mai lunga de
+// MAX_QUERY_LINE octeti primeste "ERR" si conexiunea se inchide.
+
+// lungimea maxima a unei interogari primite de server
+const size_t MAX_QUERY_LINE = 64 * 1024;
+
+// Citeste linii dintr-un descriptor, printr-un buffer propriu. Cu
+// max_line != 0, o linie mai lunga opreste citirea (vezi tooLong).
+class LineReader {
+private:
+    int fd;
+    size_t max_line;
+    std::string buffer;
+    size_t start = 0;
+    size_t scanned = 0; // pana aici buffer-ul nu contine '\n'
+    bool too_long = false;
+
+public:
+    explicit LineReader(int socket_fd, size_t max_line = 0)
+        : fd(socket_fd), max_line(max_line) {}
+
+    // urmatoarea linie, fara '\n'; false la sfarsitul conexiunii sau la o
+    // linie prea lunga
+    bool next(std::string& line) {
+        for(;;) {
+            size_t end = buffer.find('\n', std::max(start, scanned));
+            if(end != std::string::npos) {
+                line.assign(buffer, start, end - start);
+                start = end + 1;
+                return true;
+            }
+            buffer.erase(0, start);
+            start = 0;
+            scanned = buffer.size();
+            if(max_line != 0 && buffer.size() > max_line) {
+                too_long = true;
+                return false;
+            }
+            char chunk[4096];
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if(n <= 0) {
+                return false;
+            }
+            buffer.append(chunk, n);
+        }
+    }
+
+    // next a intors false din cauza unei linii mai lungi decat max_line
+    bool tooLong() const {
+        return too_long;
+    }
+};
+
+inline bool sendAll(int fd, const std::string& data) {
+    size_t done = 0;
+    while(done < data.size()) {
+        ssize_t n = ::send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if(n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// formateaza raspunsul unei interogari
+inline void formatResult(const std::vector<uint32_t>& ids, std::string& out) {
+    char number[16];
+    out = std::to_string(ids.size()) + ":";
+    for(size_t i = 0; i < ids.size(); i++) {
+        if(i > 0) out += ' ';
+        out.append(number, std::to_chars(number, number + sizeof(number), ids[i]).ptr);
+    }
+    out += '\n';
+}
+
+inline sockaddr_un unixAddress(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Calea socket-ului este prea lunga: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+// Serverul: indexul se incarca o singura data, iar fiecare conexiune e
+// servita de propriul thread (indexul mapat e doar citit)
+inline int runQueryServer(const IndexFile& index, const std::string& socket_path) {
+    sockaddr_un address = unixAddress(socket_path);
+    int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(server < 0) {
+        std::cerr << "Eroare la crearea socket-ului" << std::endl;
+        return EXIT_FAILURE;
+    }
+    // un socket ramas de la o rulare anterioara se inlocuieste; orice alt
+    // fisier de la aceasta cale se pastreaza
+    struct stat st{};
+    if(::lstat(socket_path.c_str(), &st) == 0) {
+        if(!S_ISSOCK(st.st_mode)) {
+            std::cerr << "Calea exista si nu este un socket: " << socket_path << std::endl;
+            ::close(server);
+            return EXIT_FAILURE;
+        }
+        ::unlink(socket_path.c_str());
+    }
+    if(::bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+       ::listen(server, 64) != 0) {
+        std::cerr << "Eroare la deschiderea socket-ului: " << socket_path << std::endl;
+        ::close(server);
+        return EXIT_FAILURE;
+    }
+    std::cout << "Serverul asculta pe " << socket_path << " (" << index.size() << " termeni)" << std::endl;
+
+    QueryEngine engine(index);
+    for(;;) {
+        int client = ::accept(server, nullptr, nullptr);
+        if(client < 0) {
+            if(errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            // prea multe descriptoare sau memorie insuficienta: se reincearca
+            // dupa ce se inchid conexiuni; altfel socket-ul nu mai e folosibil
+            if(errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            std::cerr << "Eroare la acceptarea conexiunilor: " << std::strerror(errno) << std::endl;
+            ::close(server);
+            return EXIT_FAILURE;
+        }
+        std::thread([&engine, client]() {
+            LineReader reader(client, MAX_QUERY_LINE);
+            std::string line, response;
+            std::vector<uint32_t> ids;
+            while(reader.next(line)) {
+                try {
+                    engine.run(line, ids);
+                    formatResult(ids, response);
+                } catch(const std::exception& e) {
+                    // orice eroare (si std::bad_alloc) ramane in conexiunea ei
+                    response = std::string("ERR ") + e.what() + "\n";
+                }
+                if(!sendAll(client, response)) break;
+            }
+            if(reader.tooLong()) {
+                sendAll(client, "ERR Interogarea depaseste " + std::to_string(MAX_QUERY_LINE) +
+                                " de octeti\n");
+            }
+            ::close(client);
+        }).detach();
+    }
+}
+
+// Clientul de benchmark: trimite fiecare interogare de iterations ori, pe
+// rand, si masoara latenta fiecarei cereri (de la trimitere la raspuns)
+inline int runQueryBench(const std::string& socket_path,
+                         const std::vector<std::string>& queries,
+                         int iterations) {
+    sockaddr_un address = unixAddress(socket_path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Eroare la conectarea la serverul: " << socket_path << std::endl;
+        if(fd >= 0) ::close(fd);
+        return EXIT_FAILURE;
+    }
+
+    LineReader reader(fd);
+    std::vector<double> latencies; // microsecunde
+    std::string response;
+    size_t errors = 0;
+    for(int it = 0; it < iterations; it++) {
+        for(const auto& query : queries) {
+            auto start = std::chrono::steady_clock::now();
+            if(!sendAll(fd, query + "\n") || !reader.next(response)) {
+                std::cerr << "Conexiunea cu serverul s-a inchis" << std::endl;
+                ::close(fd);
+                return EXIT_FAILURE;
+            }
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            if(response.compare(0, 4, "ERR ") == 0) errors++;
+        }
+    }
+    ::close(fd);
+
+    if(latencies.empty()) {
+        std::cerr << "Nicio interogare de trimis" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0;
+    for(double l : latencies) total += l;
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, size_t(p * latencies.size()))];
+    };
+    std::cout << "cereri: " << latencies.size() << ", erori: " << errors << "\n"
+              << "latenta (us): medie " << total / latencies.size()
+              << ", p50 " << percentile(0.50)
+              << ", p99 " << percentile(0.99)
+              << ", max " << latencies.back() << std::endl;
+    return EXIT_SUCCESS;
+}
+
+#endif // QUERY_SERVER_H
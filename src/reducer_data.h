@@ -0,0 +1,147 @@
+#ifndef REDUCER_DATA_H
+#define REDUCER_DATA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "concurrent_hash_index.h"
+#include "run_stats.h"
+#include "postings.h"
+#include "term_dictionary.h"
+
+// structura de date folosita de ReducerData in modul --shuffle=shared
+enum class IndexBackend {
+    Map, // std::map<TermId, Postings> sub un singur mutex
+    Hash // tabela hash concurenta, cu lock-uri pe stripe-uri
+};
+
+// Clasa pentru gestionarea datelor reducerilor
+// implementarea concreta (backend-ul) se alege la pornire cu --backend
+class ReducerData {
+public:
+    virtual ~ReducerData() = default;
+
+    // adauga aparitia termenului in fisierul dat
+    virtual void addWord(TermId term, int file_id) = 0;
+
+    // muta toate intrarile reducerului in rezultat, fara copierea postarilor;
+    // apelat o singura data, dupa terminarea mapping-ului
+    virtual std::vector<IndexEntry> takeEntries() = 0;
+};
+
+// Backend-ul initial: arbore ordonat sub un singur mutex
+class MapReducerData : public ReducerData {
+private:
+    std::map<TermId, Postings> word_map;
+    std::mutex mutex;
+
+public:
+    void addWord(TermId term, int file_id) override {
+        stats::CountedLock lock(mutex, stats::ReducerLock);
+        word_map[term].insert(file_id);
+    }
+
+    std::vector<IndexEntry> takeEntries() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<IndexEntry> result;
+        result.reserve(word_map.size());
+        for(auto& entry : word_map) {
+            result.emplace_back(entry.first, std::move(entry.second));
+        }
+        word_map.clear();
+        return result;
+    }
+};
+
+// Backend-ul hash: inserari concurente pe stripe-uri, ordinea se impune la iesire
+class HashReducerData : public ReducerData {
+private:
+    ConcurrentHashIndex index;
+
+public:
+    void addWord(TermId term, int file_id) override {
+        index.add(term, file_id);
+    }
+
+    std::vector<IndexEntry> takeEntries() override {
+        std::vector<IndexEntry> result;
+        index.drain([&result](TermId term, Postings& files) {
+            result.emplace_back(term, std::move(files));
+        });
+        return result;
+    }
+};
+
+// Creeaza structura de date a unui reducer pentru backend-ul ales
+inline std::unique_ptr<ReducerData> makeReducerData(IndexBackend backend) {
+    if(backend == IndexBackend::Hash) {
+        return std::make_unique<HashReducerData>();
+    }
+    return std::make_unique<MapReducerData>();
+}
+
+// Comparator pentru sortarea cuvintelor (orice tip de intrare cu termOf si
+// filesOf, vezi postings.h)
+template<class Entry>
+bool compareWords(const Entry& a, const Entry& b, const TermDictionary& dict) {
+    if(filesOf(a) != filesOf(b)) {
+        return filesOf(a) > filesOf(b); // Descrescator după numarul de fisiere
+    }
+    return dict.resolve(termOf(a)) < dict.resolve(termOf(b)); // Alfabetic
+}
+
+// Sorteaza cuvintele conform cerintelor (ordinea din compareWords).
+// Numarul de fisiere e marginit de numarul fisierelor de intrare, deci
+// gruparea dupa el se face cu counting sort; doar cuvintele cu acelasi numar
+// de fisiere se mai sorteaza alfabetic, cu sirurile rezolvate o singura data.
+template<class Entry>
+void sortWords(std::vector<Entry>& words, const TermDictionary& dict) {
+    struct Key {
+        std::string_view word;
+        uint32_t index; // pozitia in words
+    };
+
+    size_t max_files = 0;
+    for(const auto& entry : words) {
+        max_files = std::max(max_files, filesOf(entry));
+    }
+
+    // start[f] = prima pozitie a cuvintelor cu f fisiere (descrescator dupa f)
+    std::vector<uint32_t> start(max_files + 2, 0);
+    for(const auto& entry : words) {
+        start[max_files - filesOf(entry) + 1]++;
+    }
+    for(size_t i = 1; i < start.size(); i++) {
+        start[i] += start[i - 1];
+    }
+
+    std::vector<Key> keys(words.size());
+    for(uint32_t i = 0; i < words.size(); i++) {
+        keys[start[max_files - filesOf(words[i])]++] = {dict.resolve(termOf(words[i])), i};
+    }
+
+    // grupurile cu acelasi numar de fisiere, alfabetic
+    for(size_t begin = 0; begin < keys.size();) {
+        size_t files = filesOf(words[keys[begin].index]);
+        size_t end = begin + 1;
+        while(end < keys.size() && filesOf(words[keys[end].index]) == files) end++;
+        std::sort(keys.begin() + begin, keys.begin() + end, [](const Key& a, const Key& b) {
+            return a.word < b.word;
+        });
+        begin = end;
+    }
+
+    std::vector<Entry> sorted;
+    sorted.reserve(words.size());
+    for(const Key& key : keys) {
+        sorted.push_back(std::move(words[key.index]));
+    }
+    words.swap(sorted);
+}
+
+#endif // REDUCER_DATA_H
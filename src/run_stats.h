@@ -0,0 +1,208 @@
+#ifndef RUN_STATS_H
+#define RUN_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Instrumentarea unei rulari (--stats). Cand e dezactivata, singurul cost
+// este testarea unui bool la fiecare lock si a unui pointer nul la fiecare
+// fisier; contoarele de lock-uri sunt thread_local, deci nu se partajeaza
+// nicio linie de cache intre threaduri.
+namespace stats {
+
+using Clock = std::chrono::steady_clock;
+
+// setat o singura data, inainte de pornirea threadurilor
+inline bool enabled = false;
+
+inline double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// locurile in care threadurile se pot bloca unele pe altele
+enum LockSite {
+    ReducerLock, // ReducerData (mutex-ul map-ului sau stripe-urile tabelei hash)
+    DictionaryLock, // stripe-urile TermDictionary
+    LOCK_SITES
+};
+
+struct LockCounters {
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0; // de cate ori lock-ul era deja luat
+    uint64_t wait_ns = 0; // timpul petrecut asteptand lock-urile ocupate
+};
+
+inline thread_local LockCounters thread_locks[LOCK_SITES];
+
+// Inlocuitor pentru std::lock_guard care numara, cand instrumentarea e
+// activa, achizitiile si asteptarile
+class CountedLock {
+private:
+    std::mutex& mutex;
+
+public:
+    CountedLock(std::mutex& m, LockSite site) : mutex(m) {
+        if(!enabled) {
+            mutex.lock();
+            return;
+        }
+        LockCounters& counters = thread_locks[site];
+        counters.acquisitions++;
+        if(mutex.try_lock()) {
+            return;
+        }
+        auto start = Clock::now();
+        mutex.lock();
+        counters.contended++;
+        counters.wait_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    ~CountedLock() {
+        mutex.unlock();
+    }
+
+    CountedLock(const CountedLock&) = delete;
+    CountedLock& operator=(const CountedLock&) = delete;
+};
+
+struct MapperStats {
+    uint64_t files = 0; // fisiere sau bucati de fisiere
+    uint64_t bytes = 0;
+    uint64_t tokens = 0;
+    uint64_t terms = 0; // perechi (termen, fisier) emise
+    double open_seconds = 0; // deschiderea si maparea fisierelor
+    double tokenize_seconds = 0; // citirea paginilor, tokenizarea si normalizarea
+    double emit_seconds = 0; // trimiterea termenilor catre reduceri
+    uint64_t spills = 0; // varsarile indexului partial pe disc (--memory-budget)
+    uint64_t spill_bytes = 0;
+    uint64_t position_bytes = 0; // blocurile de pozitii (--positions)
+    LockCounters locks[LOCK_SITES];
+
+    // preia contoarele de lock-uri ale threadului curent
+    void collectLocks() {
+        for(int s = 0; s < LOCK_SITES; s++) {
+            locks[s] = thread_locks[s];
+            thread_locks[s] = LockCounters();
+        }
+    }
+};
+
+struct ReducerStats {
+    uint64_t terms = 0;
+    double shuffle_seconds = 0; // interclasarea run-urilor / preluarea intrarilor
+    double sort_seconds = 0; // sortarea si interclasarea bucatilor literelor
+    double write_seconds = 0; // scrierea literelor luate din coada
+    uint64_t letters_written = 0;
+    uint64_t output_bytes = 0;
+    uint64_t position_bytes = 0; // cheile pozitiilor sortate (--positions)
+};
+
+// Raportul unei rulari, scris ca JSON la sfarsitul lui main
+class RunReport {
+private:
+    std::vector<std::pair<std::string, double>> phases;
+    Clock::time_point start = Clock::now();
+
+    static void writeLocks(std::ostream& out, const LockCounters* locks) {
+        static const char* names[LOCK_SITES] = {"reducer_data", "dictionary"};
+        out << "{";
+        for(int s = 0; s < LOCK_SITES; s++) {
+            out << (s ? ", " : "") << "\"" << names[s] << "\": {\"acquisitions\": " << locks[s].acquisitions
+                << ", \"contended\": " << locks[s].contended
+                << ", \"wait_seconds\": " << locks[s].wait_ns / 1e9 << "}";
+        }
+        out << "}";
+    }
+
+public:
+    std::vector<std::pair<std::string, std::string>> config; // valori deja formatate JSON
+    std::vector<MapperStats> mappers;
+    std::vector<ReducerStats> reducers;
+
+    // adauga durata unei faze; fazele cu acelasi nume (de exemplu la
+    // indexarea incrementala) se aduna
+    void addPhase(const std::string& name, double seconds) {
+        for(auto& phase : phases) {
+            if(phase.first == name) {
+                phase.second += seconds;
+                return;
+            }
+        }
+        phases.emplace_back(name, seconds);
+    }
+
+    void write(std::ostream& out) const {
+        double map_seconds = 0;
+        MapperStats total;
+        uint64_t output_bytes = 0;
+        for(const auto& phase : phases) {
+            if(phase.first == "map") map_seconds = phase.second;
+        }
+        for(const auto& m : mappers) {
+            total.bytes += m.bytes;
+            total.tokens += m.tokens;
+            total.position_bytes += m.position_bytes;
+            for(int s = 0; s < LOCK_SITES; s++) {
+                total.locks[s].acquisitions += m.locks[s].acquisitions;
+                total.locks[s].contended += m.locks[s].contended;
+                total.locks[s].wait_ns += m.locks[s].wait_ns;
+            }
+        }
+        for(const auto& r : reducers) {
+            output_bytes += r.output_bytes;
+            total.position_bytes += r.position_bytes;
+        }
+
+        out << "{\n";
+        for(const auto& [name, value] : config) {
+            out << "  \"" << name << "\": " << value << ",\n";
+        }
+        out << "  \"wall_seconds\": " << secondsSince(start) << ",\n";
+        out << "  \"phases\": {";
+        for(size_t i = 0; i < phases.size(); i++) {
+            out << (i ? ", " : "") << "\"" << phases[i].first << "\": " << phases[i].second;
+        }
+        out << "},\n";
+        out << "  \"input_bytes\": " << total.bytes << ",\n";
+        out << "  \"tokens\": " << total.tokens << ",\n";
+        out << "  \"tokens_per_second\": " << (map_seconds > 0 ? total.tokens / map_seconds : 0) << ",\n";
+        out << "  \"output_bytes\": " << output_bytes << ",\n";
+        out << "  \"position_bytes\": " << total.position_bytes << ",\n";
+        out << "  \"locks\": ";
+        writeLocks(out, total.locks);
+        out << ",\n  \"mapper_threads\": [";
+        for(size_t i = 0; i < mappers.size(); i++) {
+            const MapperStats& m = mappers[i];
+            out << (i ? "," : "") << "\n    {\"files\": " << m.files << ", \"bytes\": " << m.bytes
+                << ", \"tokens\": " << m.tokens << ", \"terms\": " << m.terms
+                << ", \"open_seconds\": " << m.open_seconds
+                << ", \"tokenize_seconds\": " << m.tokenize_seconds
+                << ", \"emit_seconds\": " << m.emit_seconds
+                << ", \"spills\": " << m.spills << ", \"spill_bytes\": " << m.spill_bytes
+                << ", \"position_bytes\": " << m.position_bytes << ", \"locks\": ";
+            writeLocks(out, m.locks);
+            out << "}";
+        }
+        out << (mappers.empty() ? "" : "\n  ") << "],\n  \"reducer_threads\": [";
+        for(size_t i = 0; i < reducers.size(); i++) {
+            const ReducerStats& r = reducers[i];
+            out << (i ? "," : "") << "\n    {\"terms\": " << r.terms
+                << ", \"shuffle_seconds\": " << r.shuffle_seconds
+                << ", \"sort_seconds\": " << r.sort_seconds
+                << ", \"write_seconds\": " << r.write_seconds
+                << ", \"letters_written\": " << r.letters_written
+                << ", \"output_bytes\": " << r.output_bytes
+                << ", \"position_bytes\": " << r.position_bytes << "}";
+        }
+        out << (reducers.empty() ? "" : "\n  ") << "]\n}\n";
+    }
+};
+
+} // namespace stats
+
+#endif // RUN_STATS_H
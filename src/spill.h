@@ -0,0 +1,283 @@
+#ifndef SPILL_H
+#define SPILL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "index_file.h"
+#include "input_reader.h"
+#include "postings.h"
+#include "term_dictionary.h"
+
+// Indexarea cu buget de memorie (--memory-budget). Cand indexul partial al
+// unui mapper depaseste bugetul, fiecare partitie se scrie pe disc ca run
+// sortat dupa TermId. Formatul unui run: pentru fiecare termen, varint(term),
+// varint(numarul de fisiere), apoi id-urile crescatoare codificate ca
+// diferente (ca in indexul binar). La reduce, run-urile unei partitii se
+// interclaseaza in flux intr-un fisier cu postarile finale; in memorie
+// raman doar cheile termenilor (SpilledKey), nu si postarile lor.
+
+// Directorul temporar al unei rulari, sters la distrugere
+class SpillDirectory {
+private:
+    std::string dir;
+
+public:
+    // creeaza un director unic in base (sau in $TMPDIR / /tmp daca base e gol)
+    explicit SpillDirectory(const std::string& base) {
+        std::string parent = base;
+        if(parent.empty()) {
+            const char* tmp = std::getenv("TMPDIR");
+            parent = tmp != nullptr && *tmp != '\0' ? tmp : "/tmp";
+        }
+        std::error_code error;
+        std::filesystem::create_directories(parent, error);
+        std::string pattern = parent + "/tema1-spill-XXXXXX";
+        if(mkdtemp(pattern.data()) != nullptr) {
+            dir = pattern;
+        }
+    }
+
+    ~SpillDirectory() {
+        if(!dir.empty()) {
+            std::error_code error;
+            std::filesystem::remove_all(dir, error);
+        }
+    }
+
+    SpillDirectory(const SpillDirectory&) = delete;
+    SpillDirectory& operator=(const SpillDirectory&) = delete;
+
+    bool isOpen() const {
+        return !dir.empty();
+    }
+
+    std::string pathOf(const std::string& name) const {
+        return dir + "/" + name;
+    }
+};
+
+// Scrie octetii acumulati intr-un fisier, in blocuri de BUFFER_SIZE
+class SpillWriter {
+private:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    int fd;
+    bool failed = false;
+    uint64_t written = 0;
+
+public:
+    std::vector<uint8_t> buffer;
+
+    explicit SpillWriter(const std::string& path)
+        : fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600)) {
+        failed = fd < 0;
+        buffer.reserve(BUFFER_SIZE + 64);
+    }
+
+    // scrie intr-un descriptor deja deschis (de exemplu un memfd), de la
+    // pozitia lui curenta; descriptorul se inchide la close
+    explicit SpillWriter(int descriptor) : fd(descriptor) {
+        failed = fd < 0;
+        buffer.reserve(BUFFER_SIZE + 64);
+    }
+
+    ~SpillWriter() {
+        close();
+    }
+
+    SpillWriter(const SpillWriter&) = delete;
+    SpillWriter& operator=(const SpillWriter&) = delete;
+
+    // pozitia curenta in fisier (octetii scrisi plus cei din buffer)
+    uint64_t offset() const {
+        return written + buffer.size();
+    }
+
+    // apelat dupa fiecare inregistrare; scrie buffer-ul cand s-a umplut
+    void maybeFlush() {
+        if(buffer.size() >= BUFFER_SIZE) flush();
+    }
+
+    void flush() {
+        size_t done = 0;
+        while(done < buffer.size() && !failed) {
+            ssize_t n = ::write(fd, buffer.data() + done, buffer.size() - done);
+            if(n < 0) {
+                failed = true;
+            } else {
+                done += static_cast<size_t>(n);
+            }
+        }
+        written += buffer.size();
+        buffer.clear();
+    }
+
+    // false daca vreo scriere a esuat
+    bool close() {
+        if(fd >= 0) {
+            flush();
+            failed |= ::close(fd) != 0;
+            fd = -1;
+        }
+        return !failed;
+    }
+};
+
+// Scrie un run sortat dupa TermId; bytes primeste dimensiunea fisierului
+inline bool writeRun(const std::string& path, const std::vector<IndexEntry>& run, uint64_t& bytes) {
+    SpillWriter writer(path);
+    for(const auto& entry : run) {
+        appendVarint(writer.buffer, entry.first);
+        appendVarint(writer.buffer, static_cast<uint32_t>(entry.second.size()));
+        uint32_t previous = 0;
+        entry.second.forEach([&](int file_id) {
+            appendVarint(writer.buffer, static_cast<uint32_t>(file_id) - previous);
+            previous = static_cast<uint32_t>(file_id);
+        });
+        writer.maybeFlush();
+    }
+    bytes = writer.offset();
+    return writer.close();
+}
+
+// Cheia unui termen din postarile interclasate ale unui reducer: postarile
+// sunt in fisierul reducerului part, la offset
+struct SpilledKey {
+    TermId term;
+    uint32_t files;
+    uint32_t part;
+    uint32_t bytes;
+    uint64_t offset;
+};
+
+inline TermId termOf(const SpilledKey& key) {
+    return key.term;
+}
+
+inline size_t filesOf(const SpilledKey& key) {
+    return key.files;
+}
+
+// parcurge crescator id-urile unei chei, din fisierul mapat al reducerului ei
+template<class F>
+void forEachSpilledId(std::string_view merged, const SpilledKey& key, F&& callback) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(merged.data()) + key.offset;
+    const uint8_t* end = p + key.bytes;
+    uint32_t id = 0;
+    while(p < end) {
+        id += readVarint(p, end);
+        callback(static_cast<int>(id));
+    }
+}
+
+// Interclaseaza (k-way merge, in flux) run-urile unei partitii: cele ramase
+// in memorie (sortate dupa TermId) si cele de pe disc. Postarile reunite se
+// scriu in merged_path, iar cheile termenilor se grupeaza in by_letter dupa
+// prima litera. part este indexul reducerului (se copiaza in chei).
+inline bool mergeSpilledRuns(const std::vector<std::vector<IndexEntry>*>& memory_runs,
+                             const std::vector<std::string>& run_files,
+                             const std::string& merged_path,
+                             uint32_t part,
+                             const TermDictionary& dict,
+                             std::vector<std::vector<SpilledKey>>& by_letter) {
+    // cursorul unei surse: un run din memorie sau un fisier mapat
+    struct Source {
+        const std::vector<IndexEntry>* run = nullptr;
+        size_t index = 0;
+        std::unique_ptr<MappedFile> file;
+        const uint8_t* p = nullptr;
+        const uint8_t* end = nullptr;
+        TermId term = 0;
+        uint32_t count = 0; // doar pentru fisiere
+
+        // avanseaza la urmatorul termen; false la sfarsitul sursei
+        bool next() {
+            if(run != nullptr) {
+                if(index >= run->size()) return false;
+                term = (*run)[index].first;
+                return true;
+            }
+            if(p >= end) return false;
+            term = readVarint(p, end);
+            count = readVarint(p, end);
+            return true;
+        }
+
+        // adauga id-urile termenului curent si trece mai departe
+        bool take(std::vector<uint32_t>& ids) {
+            if(run != nullptr) {
+                (*run)[index++].second.forEach([&ids](int id) { ids.push_back(static_cast<uint32_t>(id)); });
+            } else {
+                uint32_t id = 0;
+                for(uint32_t i = 0; i < count; i++) {
+                    id += readVarint(p, end);
+                    ids.push_back(id);
+                }
+            }
+            return next();
+        }
+    };
+
+    std::vector<Source> sources(memory_runs.size() + run_files.size());
+    for(size_t i = 0; i < memory_runs.size(); i++) {
+        sources[i].run = memory_runs[i];
+    }
+    for(size_t i = 0; i < run_files.size(); i++) {
+        Source& source = sources[memory_runs.size() + i];
+        source.file = std::make_unique<MappedFile>(run_files[i]);
+        if(!source.file->isOpen()) {
+            return false;
+        }
+        std::string_view data = source.file->data();
+        source.p = reinterpret_cast<const uint8_t*>(data.data());
+        source.end = source.p + data.size();
+    }
+
+    auto greater = [&sources](size_t a, size_t b) {
+        return sources[a].term > sources[b].term;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+    for(size_t i = 0; i < sources.size(); i++) {
+        if(sources[i].next()) heap.push(i);
+    }
+
+    SpillWriter writer(merged_path);
+    std::vector<uint32_t> ids;
+    while(!heap.empty()) {
+        TermId term = sources[heap.top()].term;
+        ids.clear();
+        // toate sursele cu acelasi termen; fisierele lor sunt disjuncte,
+        // dar nu neaparat in ordine
+        while(!heap.empty() && sources[heap.top()].term == term) {
+            size_t s = heap.top();
+            heap.pop();
+            if(sources[s].take(ids)) heap.push(s);
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        uint64_t offset = writer.offset();
+        uint32_t previous = 0;
+        for(uint32_t id : ids) {
+            appendVarint(writer.buffer, id - previous);
+            previous = id;
+        }
+        by_letter[letterOf(dict.resolve(term)) - 'a'].push_back(
+            {term, static_cast<uint32_t>(ids.size()), part,
+             static_cast<uint32_t>(writer.offset() - offset), offset});
+        writer.maybeFlush();
+    }
+    return writer.close();
+}
+
+#endif // SPILL_H
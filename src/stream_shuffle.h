@@ -0,0 +1,193 @@
+#ifndef STREAM_SHUFFLE_H
+#define STREAM_SHUFFLE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "term_dictionary.h"
+
+// O inregistrare din shuffle: termenul si fisierul in care apare
+struct ShuffleRecord {
+    TermId term;
+    int file_id;
+};
+
+using RecordBatch = std::vector<ShuffleRecord>;
+
+// Coada circulara lock-free cu un singur producator si un singur consumator
+template<class T>
+class SpscQueue {
+private:
+    std::unique_ptr<T[]> items;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0}; // urmatoarea pozitie de citit
+    alignas(64) std::atomic<size_t> tail{0}; // urmatoarea pozitie de scris
+
+public:
+    // capacity trebuie sa fie putere a lui 2
+    explicit SpscQueue(size_t capacity) : items(new T[capacity]), mask(capacity - 1) {}
+
+    bool tryPush(T item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) > mask) {
+            return false; // coada plina
+        }
+        items[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if(h == tail.load(std::memory_order_acquire)) {
+            return false; // coada goala
+        }
+        item = items[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Shuffle in flux intre mapperi si reduceri: cate o coada SPSC marginita
+// pentru fiecare pereche (mapper, reducer), prin care circula loturi de
+// inregistrari. Reducerii consuma loturile cat timp mapperii inca lucreaza;
+// o coada plina blocheaza mapper-ul (backpressure) pana se elibereaza loc.
+class StreamShuffle {
+public:
+    static const size_t BATCH_RECORDS = 4096;
+    static const size_t QUEUE_BATCHES = 64; // putere a lui 2
+
+private:
+    struct alignas(64) ReducerWakeup {
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+
+    int num_mappers;
+    int num_reducers;
+    std::vector<std::unique_ptr<SpscQueue<RecordBatch*>>> queues; // [mapper * R + reducer]
+    std::unique_ptr<ReducerWakeup[]> wakeups;
+    std::atomic<int> active_mappers;
+
+    SpscQueue<RecordBatch*>& queue(int mapper, int reducer) {
+        return *queues[mapper * num_reducers + reducer];
+    }
+
+public:
+    StreamShuffle(int mappers, int reducers)
+        : num_mappers(mappers), num_reducers(reducers),
+          wakeups(new ReducerWakeup[reducers]), active_mappers(mappers) {
+        for(int i = 0; i < mappers * reducers; i++) {
+            queues.push_back(std::make_unique<SpscQueue<RecordBatch*>>(QUEUE_BATCHES));
+        }
+    }
+
+    ~StreamShuffle() {
+        // loturile ramase (doar daca un reducer s-a oprit prematur)
+        RecordBatch* batch;
+        for(auto& q : queues) {
+            while(q->tryPop(batch)) delete batch;
+        }
+    }
+
+    // trimite un lot catre reducer; asteapta cat timp coada e plina
+    void push(int mapper, int reducer, RecordBatch* batch) {
+        auto& q = queue(mapper, reducer);
+        while(!q.tryPush(batch)) {
+            wakeups[reducer].cond.notify_one();
+            std::this_thread::yield();
+        }
+        wakeups[reducer].cond.notify_one();
+    }
+
+    // semnaleaza ca mapper-ul a trimis toate loturile
+    void mapperDone() {
+        if(active_mappers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            for(int r = 0; r < num_reducers; r++) {
+                std::lock_guard<std::mutex> lock(wakeups[r].mutex);
+                wakeups[r].cond.notify_all();
+            }
+        }
+    }
+
+    // consuma toate loturile destinate reducerului, pana cand toti mapperii
+    // au terminat si cozile sunt goale; callback-ul primeste fiecare lot
+    template<class F>
+    void consume(int reducer, F&& on_batch) {
+        for(;;) {
+            // valoarea citita inainte de golire: daca era 0, tot ce s-a
+            // trimis e deja vizibil si golirea de mai jos e ultima
+            bool finished = active_mappers.load(std::memory_order_acquire) == 0;
+            bool got = false;
+            RecordBatch* batch;
+            for(int m = 0; m < num_mappers; m++) {
+                while(queue(m, reducer).tryPop(batch)) {
+                    on_batch(*batch);
+                    delete batch;
+                    got = true;
+                }
+            }
+            if(finished) {
+                return;
+            }
+            if(!got) {
+                // nimic de facut: se asteapta un lot nou (cu timeout, ca sa
+                // nu se piarda o notificare trimisa fara lock)
+                std::unique_lock<std::mutex> lock(wakeups[reducer].mutex);
+                wakeups[reducer].cond.wait_for(lock, std::chrono::microseconds(200));
+            }
+        }
+    }
+};
+
+// Partea de producator a unui mapper: tine cate un lot deschis pentru
+// fiecare reducer si il trimite cand se umple
+class StreamProducer {
+private:
+    StreamShuffle& shuffle;
+    int mapper;
+    std::vector<RecordBatch*> open_batches;
+
+public:
+    StreamProducer(StreamShuffle& stream, int mapper_id, int num_reducers)
+        : shuffle(stream), mapper(mapper_id), open_batches(num_reducers, nullptr) {}
+
+    StreamProducer(const StreamProducer&) = delete;
+    StreamProducer& operator=(const StreamProducer&) = delete;
+
+    ~StreamProducer() {
+        for(RecordBatch* batch : open_batches) delete batch;
+    }
+
+    void emit(int reducer, TermId term, int file_id) {
+        RecordBatch*& batch = open_batches[reducer];
+        if(batch == nullptr) {
+            batch = new RecordBatch();
+            batch->reserve(StreamShuffle::BATCH_RECORDS);
+        }
+        batch->push_back({term, file_id});
+        if(batch->size() == StreamShuffle::BATCH_RECORDS) {
+            shuffle.push(mapper, reducer, batch);
+            batch = nullptr;
+        }
+    }
+
+    // trimite loturile incomplete si anunta sfarsitul mapper-ului
+    void finish() {
+        for(size_t r = 0; r < open_batches.size(); r++) {
+            if(open_batches[r] != nullptr) {
+                shuffle.push(mapper, static_cast<int>(r), open_batches[r]);
+                open_batches[r] = nullptr;
+            }
+        }
+        shuffle.mapperDone();
+    }
+};
+
+#endif // STREAM_SHUFFLE_H
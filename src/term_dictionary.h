@@ -0,0 +1,262 @@
+#ifndef TERM_DICTIONARY_H
+#define TERM_DICTIONARY_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "run_stats.h"
+
+// Id-ul unui termen din dictionar, pe 32 de biti
+using TermId = uint32_t;
+
+// Hash pe 64 de biti pentru cuvinte (FNV-1a urmat de un pas de mixare,
+// ca bitii de sus - folositi la alegerea stripe-ului - sa fie bine amestecati)
+inline uint64_t hashWord(std::string_view word) {
+    uint64_t h = 1469598103934665603ull;
+    for(char c : word) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+// Zona de memorie in care se copiaza sirurile o singura data; sirurile
+// nu se muta niciodata, deci string_view-urile catre ele raman valide
+class StringArena {
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks; // blocuri pentru sirurile obisnuite
+    std::vector<std::unique_ptr<char[]>> large; // sirurile foarte lungi, separat
+    size_t used = BLOCK_SIZE; // ocuparea ultimului bloc
+
+public:
+    std::string_view store(std::string_view word) {
+        char* dst;
+        if(word.size() > BLOCK_SIZE / 4) {
+            large.emplace_back(new char[word.size()]);
+            dst = large.back().get();
+        } else {
+            if(used + word.size() > BLOCK_SIZE) {
+                blocks.emplace_back(new char[BLOCK_SIZE]);
+                used = 0;
+            }
+            dst = blocks.back().get() + used;
+            used += word.size();
+        }
+        std::memcpy(dst, word.data(), word.size());
+        return std::string_view(dst, word.size());
+    }
+};
+
+// Dictionar global de termeni: fiecare cuvant distinct primeste un TermId
+// pe 32 de biti, iar sirul e stocat o singura data, intr-un arena.
+// Dictionarul e impartit in stripe-uri, fiecare cu mutex, tabela hash cu
+// adresare deschisa si arena proprii. Id-ul codifica stripe-ul in bitii de
+// jos, deci resolve() nu are nevoie de lock si poate fi apelat concurent cu
+// intern() pentru orice id deja primit.
+class TermDictionary {
+private:
+    static const uint32_t STRIPE_BITS = 6;
+    static const uint32_t NUM_STRIPES = 1u << STRIPE_BITS;
+    static const size_t INITIAL_CAPACITY = 1024; // sloturi per stripe, putere a lui 2
+    // termenii unui stripe se tin in blocuri fixe, adresate printr-un director
+    // de dimensiune fixa, ca resolve() sa nu vada niciodata o realocare
+    static const uint32_t TERMS_PER_BLOCK = 4096;
+    static const uint32_t MAX_BLOCKS = 1024;
+
+    struct Slot {
+        uint64_t hash = 0; // 0 inseamna slot liber
+        const char* data = nullptr;
+        uint32_t len = 0;
+        TermId id = 0;
+    };
+
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        std::unique_ptr<Slot[]> slots;
+        size_t capacity = 0;
+        uint32_t count = 0; // numarul de termeni din stripe
+        StringArena arena;
+        std::unique_ptr<std::atomic<std::string_view*>[]> directory;
+    };
+
+    std::unique_ptr<Stripe[]> stripes;
+    std::atomic<uint32_t> total{0};
+
+    static uint64_t fixHash(uint64_t hash) {
+        return hash == 0 ? 1 : hash;
+    }
+
+    static Slot* findSlot(Slot* slots, size_t capacity, uint64_t hash, std::string_view word) {
+        size_t mask = capacity - 1;
+        for(size_t i = hash & mask;; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if(slot.hash == 0 ||
+               (slot.hash == hash && std::string_view(slot.data, slot.len) == word)) {
+                return &slot;
+            }
+        }
+    }
+
+    static void grow(Stripe& stripe) {
+        size_t new_capacity = stripe.capacity * 2;
+        std::unique_ptr<Slot[]> new_slots(new Slot[new_capacity]);
+        for(size_t i = 0; i < stripe.capacity; i++) {
+            const Slot& old = stripe.slots[i];
+            if(old.hash == 0) continue;
+            *findSlot(new_slots.get(), new_capacity, old.hash,
+                      std::string_view(old.data, old.len)) = old;
+        }
+        stripe.slots = std::move(new_slots);
+        stripe.capacity = new_capacity;
+    }
+
+public:
+    TermDictionary() : stripes(new Stripe[NUM_STRIPES]) {
+        for(uint32_t s = 0; s < NUM_STRIPES; s++) {
+            stripes[s].slots.reset(new Slot[INITIAL_CAPACITY]);
+            stripes[s].capacity = INITIAL_CAPACITY;
+            stripes[s].directory.reset(new std::atomic<std::string_view*>[MAX_BLOCKS]());
+        }
+    }
+
+    ~TermDictionary() {
+        for(uint32_t s = 0; s < NUM_STRIPES; s++) {
+            for(uint32_t b = 0; b < MAX_BLOCKS; b++) {
+                delete[] stripes[s].directory[b].load();
+            }
+        }
+    }
+
+    TermDictionary(const TermDictionary&) = delete;
+    TermDictionary& operator=(const TermDictionary&) = delete;
+
+    // intoarce id-ul cuvantului, adaugandu-l daca nu exista; hash = hashWord(word)
+    TermId intern(std::string_view word, uint64_t hash) {
+        hash = fixHash(hash);
+        uint32_t s = static_cast<uint32_t>(hash >> (64 - STRIPE_BITS));
+        Stripe& stripe = stripes[s];
+        stats::CountedLock lock(stripe.mutex, stats::DictionaryLock);
+
+        Slot* slot = findSlot(stripe.slots.get(), stripe.capacity, hash, word);
+        if(slot->hash != 0) {
+            return slot->id;
+        }
+
+        uint32_t local = stripe.count;
+        uint32_t block = local / TERMS_PER_BLOCK;
+        if(block >= MAX_BLOCKS) {
+            throw std::length_error("Dictionarul de termeni este plin");
+        }
+        if((stripe.count + 1) * 4 > stripe.capacity * 3) {
+            grow(stripe);
+            slot = findSlot(stripe.slots.get(), stripe.capacity, hash, word);
+        }
+
+        std::string_view stored = stripe.arena.store(word);
+        std::string_view* terms = stripe.directory[block].load(std::memory_order_relaxed);
+        if(terms == nullptr) {
+            terms = new std::string_view[TERMS_PER_BLOCK];
+        }
+        terms[local % TERMS_PER_BLOCK] = stored;
+        // publica blocul (si termenul) inainte ca id-ul sa poata fi folosit
+        stripe.directory[block].store(terms, std::memory_order_release);
+
+        TermId id = (local << STRIPE_BITS) | s;
+        slot->hash = hash;
+        slot->data = stored.data();
+        slot->len = static_cast<uint32_t>(stored.size());
+        slot->id = id;
+        stripe.count++;
+        total.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    // sirul corespunzator unui id primit de la intern()
+    std::string_view resolve(TermId id) const {
+        const Stripe& stripe = stripes[id & (NUM_STRIPES - 1)];
+        uint32_t local = id >> STRIPE_BITS;
+        const std::string_view* terms =
+            stripe.directory[local / TERMS_PER_BLOCK].load(std::memory_order_acquire);
+        return terms[local % TERMS_PER_BLOCK];
+    }
+
+    // numarul total de termeni distincti
+    size_t size() const {
+        return total.load(std::memory_order_relaxed);
+    }
+};
+
+// Cache local al unui mapper in fata dictionarului global: fiecare token se
+// cauta intai aici, fara lock, si doar termenii noi pentru mapper ajung in
+// TermDictionary. Cheile sunt string_view-uri catre arena dictionarului.
+// Slotul retine si ultimul fisier in care a aparut termenul, astfel incat
+// deduplicarea cuvintelor unui fisier nu mai are nevoie de un set separat.
+class TermCache {
+public:
+    struct Entry {
+        uint64_t hash = 0; // 0 inseamna slot liber
+        std::string_view word;
+        TermId id = 0;
+        int last_file = 0; // ultimul fisier (file_id) in care a fost vazut
+        uint32_t file_slot = 0; // indicele termenului in termenii lui last_file
+    };
+
+private:
+    TermDictionary& dict;
+    std::vector<Entry> slots;
+    size_t count = 0;
+
+    Entry* findSlot(uint64_t hash, std::string_view word) {
+        size_t mask = slots.size() - 1;
+        for(size_t i = hash & mask;; i = (i + 1) & mask) {
+            Entry& e = slots[i];
+            if(e.hash == 0 || (e.hash == hash && e.word == word)) {
+                return &e;
+            }
+        }
+    }
+
+    void grow() {
+        std::vector<Entry> old(slots.size() * 2);
+        old.swap(slots);
+        for(const Entry& e : old) {
+            if(e.hash != 0) *findSlot(e.hash, e.word) = e;
+        }
+    }
+
+public:
+    explicit TermCache(TermDictionary& dictionary) : dict(dictionary), slots(4096) {}
+
+    // intrarea termenului (creata la nevoie); word trebuie sa fie nevid
+    Entry& lookup(std::string_view word) {
+        uint64_t hash = hashWord(word);
+        hash = hash == 0 ? 1 : hash;
+        Entry* e = findSlot(hash, word);
+        if(e->hash != 0) {
+            return *e;
+        }
+        if((count + 1) * 2 > slots.size()) {
+            grow();
+            e = findSlot(hash, word);
+        }
+        TermId id = dict.intern(word, hash);
+        e->hash = hash;
+        e->word = dict.resolve(id);
+        e->id = id;
+        count++;
+        return *e;
+    }
+};
+
+#endif // TERM_DICTIONARY_H
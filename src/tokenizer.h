@@ -0,0 +1,352 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "utf8_normalize.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOKENIZER_X86 1
+#endif
+
+// Kernel-ul de tokenizare + normalizare al mapper-ului.
+// Semantica este cea a buclei originale `file >> word` + normalizeWord:
+// token-urile sunt separate de spatii (isspace in locale-ul "C"), din fiecare
+// token se pastreaza doar literele ASCII, transformate in litere mici,
+// iar token-urile care raman goale sunt ignorate. Cu --normalize=utf8|fold
+// octetii non-ASCII se pastreaza in cuvant, iar cuvintele care ii contin se
+// normalizeaza la sfarsit prin normalizeUtf8Word (vezi utf8_normalize.h).
+
+// litera ASCII: ((c | 0x20) - 'a') < 26, fara ramificatii
+inline bool isAsciiLetter(unsigned char c) {
+    return static_cast<unsigned char>((c | 0x20) - 'a') < 26;
+}
+
+// spatiu in locale-ul "C": ' ', '\t', '\n', '\v', '\f', '\r'
+inline bool isAsciiSpace(unsigned char c) {
+    return c == ' ' || static_cast<unsigned char>(c - '\t') <= 4;
+}
+
+// Normalizeaza un singur cuvant (pastreaza literele, lowercase)
+// rezultatul se scrie in buffer-ul primit, refolosit intre apeluri
+inline void normalizeWord(std::string_view word, std::string& normalized) {
+    if(activeNormalizeMode() != NormalizeMode::Ascii && hasNonAscii(word)) {
+        normalizeUtf8Word(word, normalized, activeNormalizeMode());
+        return;
+    }
+    normalized.clear();
+    for(char c : word) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if(isAsciiLetter(u)) {
+            normalized += static_cast<char>(u | 0x20);
+        }
+    }
+}
+
+// Nivelul de instructiuni vectoriale folosit de kernel
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+inline SimdLevel detectSimdLevel() {
+#ifdef TOKENIZER_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    if(__builtin_cpu_supports("sse2")) {
+        return SimdLevel::SSE2;
+    }
+#endif
+    return SimdLevel::Scalar;
+}
+
+// nivelul detectat o singura data; poate fi fortat (ex. pentru benchmark-uri)
+inline SimdLevel& activeSimdLevel() {
+    static SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+namespace tokenizer_detail {
+
+// Starea care traverseaza granitele blocurilor: cuvantul partial curent
+struct WordState {
+    std::string word;
+    bool in_word = false;
+    bool high = false; // cuvantul curent contine octeti non-ASCII
+    NormalizeMode mode = NormalizeMode::Ascii;
+    std::string folded; // cuvantul normalizat UTF-8
+};
+
+// Preda cuvantul curent (nevid). Cu Utf8, cuvintele cu octeti non-ASCII
+// trec prin normalizeUtf8Word; celelalte raman pe calea ASCII.
+template<bool Utf8, class F>
+inline void emitWord(WordState& st, F& callback) {
+    if(Utf8 && st.high) {
+        st.high = false;
+        normalizeUtf8Word(st.word, st.folded, st.mode);
+        if(!st.folded.empty()) {
+            callback(std::string_view(st.folded));
+        }
+        return;
+    }
+    callback(std::string_view(st.word));
+}
+
+// Varianta scalara, folosita si pentru arhitecturi fara SIMD
+template<bool Utf8, class F>
+void scanScalar(const char* data, size_t len, WordState& st, F& callback) {
+    for(size_t i = 0; i < len; i++) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if(isAsciiSpace(c)) {
+            if(st.in_word && !st.word.empty()) {
+                emitWord<Utf8>(st, callback);
+            }
+            st.word.clear();
+            st.in_word = false;
+        } else {
+            st.in_word = true;
+            if(isAsciiLetter(c)) {
+                st.word += static_cast<char>(c | 0x20);
+            } else if(Utf8 && c >= 0x80) {
+                st.word += static_cast<char>(c);
+                st.high = true;
+            }
+        }
+    }
+}
+
+// Parcurge un bloc de W octeti (W <= 32) pe baza mastilor de spatii / litere.
+// `lowered` contine octetii blocului cu bitul 0x20 setat (litere mici).
+// Segmentele formate doar din litere se copiaza dintr-o bucata. Cu Utf8,
+// letter_mask include si octetii non-ASCII (high_mask), lasati neschimbati
+// in `lowered`.
+template<int W, bool Utf8, class F>
+inline void walkBlock(const char* lowered, uint64_t space_mask, uint64_t letter_mask,
+                      uint64_t high_mask, WordState& st, F& callback) {
+    const uint64_t all = (uint64_t(1) << W) - 1;
+    int pos = 0;
+    while(pos < W) {
+        uint64_t above = all & (~uint64_t(0) << pos); // bitii [pos, W)
+        if(!st.in_word) {
+            uint64_t non_space = ~space_mask & above;
+            if(non_space == 0) {
+                return; // restul blocului e doar spatii
+            }
+            pos = __builtin_ctzll(non_space);
+            above = all & (~uint64_t(0) << pos);
+            st.in_word = true;
+        }
+
+        uint64_t rest_space = space_mask & above;
+        int end = rest_space ? __builtin_ctzll(rest_space) : W;
+        uint64_t segment = above & ((uint64_t(1) << end) - 1);
+        uint64_t letters = letter_mask & segment;
+        if(Utf8 && (segment & high_mask) != 0) {
+            st.high = true;
+        }
+        if(letters == segment) {
+            st.word.append(lowered + pos, end - pos);
+        } else {
+            while(letters) {
+                st.word += lowered[__builtin_ctzll(letters)];
+                letters &= letters - 1;
+            }
+        }
+
+        if(end == W) {
+            return; // cuvantul continua in blocul urmator
+        }
+        if(!st.word.empty()) {
+            emitWord<Utf8>(st, callback);
+        }
+        st.word.clear();
+        st.in_word = false;
+        pos = end + 1;
+    }
+}
+
+#ifdef TOKENIZER_X86
+
+// unsigned (x <= limit) pentru octeti, cu SSE2
+inline __m128i lessEqualU8(__m128i x, __m128i limit) {
+    return _mm_cmpeq_epi8(_mm_min_epu8(x, limit), x);
+}
+
+template<bool Utf8, class F>
+void scanSSE2(const char* data, size_t len, WordState& st, F& callback) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8(4);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i letter_a = _mm_set1_epi8('a');
+    const __m128i letters_max = _mm_set1_epi8(25);
+    alignas(16) char lowered[16];
+
+    size_t i = 0;
+    for(; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i is_space = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+                                        lessEqualU8(_mm_sub_epi8(v, tab), four));
+        __m128i low = _mm_or_si128(v, case_bit);
+        __m128i is_letter = lessEqualU8(_mm_sub_epi8(low, letter_a), letters_max);
+        uint32_t space_mask = static_cast<uint32_t>(_mm_movemask_epi8(is_space));
+        uint32_t letter_mask = static_cast<uint32_t>(_mm_movemask_epi8(is_letter));
+
+        // bloc format doar din spatii intre cuvinte: nimic de facut
+        if(space_mask == 0xFFFF && !st.in_word) {
+            continue;
+        }
+        // calea UTF-8 doar pentru blocurile cu octeti non-ASCII sau in care
+        // continua un cuvant care ii contine
+        uint32_t high_mask = Utf8 ? static_cast<uint32_t>(_mm_movemask_epi8(v)) : 0;
+        if(Utf8 && (high_mask != 0 || st.high)) {
+            // octetii non-ASCII (bitul de sus) se pastreaza nemodificati
+            __m128i high = _mm_cmplt_epi8(v, _mm_setzero_si128());
+            low = _mm_or_si128(v, _mm_andnot_si128(high, case_bit));
+            _mm_store_si128(reinterpret_cast<__m128i*>(lowered), low);
+            walkBlock<16, true>(lowered, space_mask, letter_mask | high_mask, high_mask, st, callback);
+            continue;
+        }
+        _mm_store_si128(reinterpret_cast<__m128i*>(lowered), low);
+        walkBlock<16, false>(lowered, space_mask, letter_mask, 0, st, callback);
+    }
+    scanScalar<Utf8>(data + i, len - i, st, callback);
+}
+
+template<bool Utf8, class F>
+__attribute__((target("avx2")))
+void scanAVX2(const char* data, size_t len, WordState& st, F& callback) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i four = _mm256_set1_epi8(4);
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i letter_a = _mm256_set1_epi8('a');
+    const __m256i letters_max = _mm256_set1_epi8(25);
+    alignas(32) char lowered[32];
+
+    size_t i = 0;
+    for(; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i t = _mm256_sub_epi8(v, tab);
+        __m256i is_space = _mm256_or_si256(
+            _mm256_cmpeq_epi8(v, space),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(t, four), t));
+        __m256i low = _mm256_or_si256(v, case_bit);
+        __m256i l = _mm256_sub_epi8(low, letter_a);
+        __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(l, letters_max), l);
+        uint32_t space_mask = static_cast<uint32_t>(_mm256_movemask_epi8(is_space));
+        uint32_t letter_mask = static_cast<uint32_t>(_mm256_movemask_epi8(is_letter));
+
+        if(space_mask == 0xFFFFFFFFu && !st.in_word) {
+            continue;
+        }
+        uint32_t high_mask = Utf8 ? static_cast<uint32_t>(_mm256_movemask_epi8(v)) : 0;
+        if(Utf8 && (high_mask != 0 || st.high)) {
+            __m256i high = _mm256_cmpgt_epi8(_mm256_setzero_si256(), v);
+            low = _mm256_or_si256(v, _mm256_andnot_si256(high, case_bit));
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lowered), low);
+            walkBlock<32, true>(lowered, space_mask, letter_mask | high_mask, high_mask, st, callback);
+            continue;
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lowered), low);
+        walkBlock<32, false>(lowered, space_mask, letter_mask, 0, st, callback);
+    }
+    scanScalar<Utf8>(data + i, len - i, st, callback);
+}
+
+#endif // TOKENIZER_X86
+
+} // namespace tokenizer_detail
+
+// Tokenizare incrementala: textul vine in blocuri consecutive (de exemplu
+// dintr-un fisier decomprimat in flux), iar un cuvant taiat de granita
+// dintre doua blocuri se continua in blocul urmator
+class NormalizedWordStream {
+private:
+    tokenizer_detail::WordState st;
+    SimdLevel level;
+
+    template<bool Utf8, class F>
+    void scan(std::string_view block, F& callback) {
+        switch(level) {
+#ifdef TOKENIZER_X86
+        case SimdLevel::AVX2:
+            tokenizer_detail::scanAVX2<Utf8>(block.data(), block.size(), st, callback);
+            break;
+        case SimdLevel::SSE2:
+            tokenizer_detail::scanSSE2<Utf8>(block.data(), block.size(), st, callback);
+            break;
+#endif
+        default:
+            tokenizer_detail::scanScalar<Utf8>(block.data(), block.size(), st, callback);
+            break;
+        }
+    }
+
+public:
+    explicit NormalizedWordStream(SimdLevel level = activeSimdLevel(),
+                                  NormalizeMode mode = activeNormalizeMode())
+        : level(level) {
+        st.word.reserve(64);
+        st.mode = mode;
+    }
+
+    // callback-ul primeste fiecare cuvant terminat in acest bloc
+    template<class F>
+    void feed(std::string_view block, F& callback) {
+        if(st.mode == NormalizeMode::Ascii) {
+            scan<false>(block, callback);
+        } else {
+            scan<true>(block, callback);
+        }
+    }
+
+    // ultimul cuvant, daca textul nu se termina cu un spatiu
+    template<class F>
+    void finish(F& callback) {
+        if(st.in_word && !st.word.empty()) {
+            if(st.mode == NormalizeMode::Ascii) {
+                tokenizer_detail::emitWord<false>(st, callback);
+            } else {
+                tokenizer_detail::emitWord<true>(st, callback);
+            }
+        }
+        st.word.clear();
+        st.in_word = false;
+        st.high = false;
+    }
+};
+
+// Tokenizeaza si normalizeaza textul intr-o singura trecere; callback-ul
+// primeste fiecare cuvant normalizat nevid (string_view valid doar in apel)
+template<class F>
+void forEachNormalizedWord(std::string_view text, F&& callback, SimdLevel level,
+                           NormalizeMode mode = activeNormalizeMode()) {
+    NormalizedWordStream stream(level, mode);
+    stream.feed(text, callback);
+    stream.finish(callback);
+}
+
+template<class F>
+void forEachNormalizedWord(std::string_view text, F&& callback) {
+    forEachNormalizedWord(text, std::forward<F>(callback), activeSimdLevel());
+}
+
+// Literele fisierelor de iesire: 'a'..'z' pentru cuvintele care incep cu o
+// litera ASCII, plus OTHER_LETTER ('z' + 1) pentru cele care incep cu o
+// litera non-ASCII (doar cu --normalize=utf8|fold). Ordinea literelor e cea
+// a octetilor, deci literele concatenate raman sortate alfabetic.
+const int LETTER_SLOTS = 27;
+const char OTHER_LETTER = 'z' + 1;
+
+// litera unui cuvant normalizat nevid
+inline char letterOf(std::string_view word) {
+    unsigned char c = static_cast<unsigned char>(word[0]);
+    return c < 0x80 ? static_cast<char>(c) : OTHER_LETTER;
+}
+
+#endif // TOKENIZER_H
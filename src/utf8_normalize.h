@@ -0,0 +1,381 @@
+#ifndef UTF8_NORMALIZE_H
+#define UTF8_NORMALIZE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Normalizarea cuvintelor care contin octeti non-ASCII (--normalize).
+// Implicit (ascii) se pastreaza doar literele ASCII, ca in tema originala.
+// In modul utf8 literele multi-octet se decodifica si se transforma in
+// litere mici (case folding simplu); fold elimina in plus diacriticele
+// literelor latine si grecesti (ă -> a, ș -> s, ß -> ss, ά -> α).
+// Tokenizatorul ramane pe calea ASCII pentru toate cuvintele fara octeti
+// cu bitul de sus setat; doar acestea trec prin decodorul de mai jos.
+//
+// Decodorul si tabelele:
+//  * lungimea secventei se ia dupa primul octet (UTF8_LENGTH); secventele
+//    invalide, supralungi sau surogatele se ignora octet cu octet
+//  * pentru planul de baza exista pagini de cate 256 de code point-uri
+//    (latin, latin extins, greaca, chirilica, armeana, ebraica, latin extins
+//    aditional, forme fullwidth), cu rezultatul deja codificat UTF-8 pentru
+//    fiecare mod; tabelele se construiesc o singura data, la prima folosire
+//  * in afara paginilor, un code point e litera daca intra intr-unul din
+//    intervalele LETTER_RANGES si ramane neschimbat
+
+enum class NormalizeMode {
+    Ascii, // doar litere ASCII (implicit)
+    Utf8, // litere UTF-8, lowercase
+    Fold // litere UTF-8, lowercase, fara diacritice
+};
+
+// modul folosit de tokenizator si de normalizeWord, ales o data in main
+inline NormalizeMode& activeNormalizeMode() {
+    static NormalizeMode mode = NormalizeMode::Ascii;
+    return mode;
+}
+
+namespace utf8_detail {
+
+// lungimea secventei dupa primul octet; 0 = octet de continuare sau invalid
+// (0xC0, 0xC1 si 0xF5..0xFF nu apar niciodata in UTF-8 valid)
+constexpr uint8_t UTF8_LENGTH[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+// Decodifica secventa de la data[pos]; intoarce lungimea ei (cp primeste
+// code point-ul) sau 0 pentru un octet care nu incepe o secventa valida
+inline size_t decode(std::string_view data, size_t pos, uint32_t& cp) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(data.data()) + pos;
+    size_t len = UTF8_LENGTH[s[0]];
+    if(len == 0 || pos + len > data.size()) {
+        return 0;
+    }
+    switch(len) {
+    case 1:
+        cp = s[0];
+        return 1;
+    case 2:
+        if((s[1] & 0xC0) != 0x80) return 0;
+        cp = (uint32_t(s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+        return 2;
+    case 3:
+        if((s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80) return 0;
+        cp = (uint32_t(s[0] & 0x0F) << 12) | (uint32_t(s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        // supralung sau surogat
+        return cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF) ? 0 : 3;
+    default:
+        if((s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 || (s[3] & 0xC0) != 0x80) return 0;
+        cp = (uint32_t(s[0] & 0x07) << 18) | (uint32_t(s[1] & 0x3F) << 12)
+           | (uint32_t(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        return cp < 0x10000 || cp > 0x10FFFF ? 0 : 4;
+    }
+}
+
+inline void encode(uint32_t cp, std::string& out) {
+    if(cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if(cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if(cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// litere (neschimbate) in afara paginilor tabelate: scrieri fara litere
+// mari (arab, indic, CJK, hangul...); punctuatia generala, simbolurile,
+// zona privata si emoji raman in afara
+struct Range {
+    uint32_t first, last;
+};
+const Range LETTER_RANGES[] = {
+    {0x0600, 0x1DFF}, {0x1F00, 0x1FFF}, {0x2C00, 0x2DFF}, {0x2E80, 0x2FFF},
+    {0x3040, 0xD7FF}, {0xF900, 0xFDFF}, {0xFE70, 0xFEFE}, {0x10000, 0x1EFFF},
+    {0x20000, 0x3FFFF},
+};
+
+inline bool inLetterRange(uint32_t cp) {
+    const Range* end = LETTER_RANGES + sizeof(LETTER_RANGES) / sizeof(Range);
+    const Range* r = std::upper_bound(LETTER_RANGES, end, cp, [](uint32_t value, const Range& range) {
+        return value < range.first;
+    });
+    return r != LETTER_RANGES && cp <= (r - 1)->last;
+}
+
+// Perechile (litera mare, litera mica) neregulate din latina extinsa B
+// (0x180-0x24F), dupa UnicodeData: literele africane si vietnameze (Ơ, Ư),
+// digrafele (Ǆ/ǅ -> ǆ) si literele mari ale caror litere mici sunt in IPA;
+// restul blocului alterneaza mare/mic si e tratat in lowerOf
+struct CasePair {
+    uint32_t upper, lower;
+};
+const CasePair LATIN_B_LOWER[] = {
+    {0x181, 0x253}, {0x182, 0x183}, {0x184, 0x185}, {0x186, 0x254}, {0x187, 0x188}, {0x189, 0x256},
+    {0x18A, 0x257}, {0x18B, 0x18C}, {0x18E, 0x1DD}, {0x18F, 0x259}, {0x190, 0x25B}, {0x191, 0x192},
+    {0x193, 0x260}, {0x194, 0x263}, {0x196, 0x269}, {0x197, 0x268}, {0x198, 0x199}, {0x19C, 0x26F},
+    {0x19D, 0x272}, {0x19F, 0x275}, {0x1A0, 0x1A1}, {0x1A2, 0x1A3}, {0x1A4, 0x1A5}, {0x1A6, 0x280},
+    {0x1A7, 0x1A8}, {0x1A9, 0x283}, {0x1AC, 0x1AD}, {0x1AE, 0x288}, {0x1AF, 0x1B0}, {0x1B1, 0x28A},
+    {0x1B2, 0x28B}, {0x1B3, 0x1B4}, {0x1B5, 0x1B6}, {0x1B7, 0x292}, {0x1B8, 0x1B9}, {0x1BC, 0x1BD},
+    {0x1C4, 0x1C6}, {0x1C5, 0x1C6}, {0x1C7, 0x1C9}, {0x1C8, 0x1C9}, {0x1CA, 0x1CC}, {0x1CB, 0x1CC},
+    {0x1F1, 0x1F3}, {0x1F2, 0x1F3}, {0x1F4, 0x1F5}, {0x1F6, 0x195}, {0x1F7, 0x1BF}, {0x220, 0x19E},
+    {0x23A, 0x2C65}, {0x23B, 0x23C}, {0x23D, 0x19A}, {0x23E, 0x2C66}, {0x241, 0x242}, {0x243, 0x180},
+    {0x244, 0x289}, {0x245, 0x28C}, {0x246, 0x247}, {0x248, 0x249}, {0x24A, 0x24B}, {0x24C, 0x24D},
+    {0x24E, 0x24F},
+};
+
+// litera mica a unui code point din paginile tabelate, 0 daca nu e litera
+inline uint32_t lowerOf(uint32_t cp) {
+    auto between = [cp](uint32_t first, uint32_t last) {
+        return cp >= first && cp <= last;
+    };
+    if(cp < 0x80) {
+        return static_cast<unsigned char>((cp | 0x20) - 'a') < 26 ? (cp | 0x20) : 0;
+    }
+    if(cp < 0xC0) {
+        if(cp == 0xAA || cp == 0xBA) return cp; // indicatori ordinali
+        return cp == 0xB5 ? 0x3BC : 0; // micro -> mu
+    }
+    if(cp < 0x100) {
+        if(cp == 0xD7 || cp == 0xF7) return 0; // semnele de inmultire / impartire
+        return cp <= 0xDE ? cp + 0x20 : cp;
+    }
+    if(cp < 0x180) {
+        if(cp == 0x130) return 'i';
+        if(cp == 0x178) return 0xFF;
+        if(cp == 0x17F) return 's';
+        if((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E)) {
+            return cp % 2 == 1 ? cp + 1 : cp;
+        }
+        if(cp == 0x138 || cp == 0x149) return cp;
+        return cp % 2 == 0 ? cp + 1 : cp;
+    }
+    if(cp < 0x250) {
+        const CasePair* end = LATIN_B_LOWER + sizeof(LATIN_B_LOWER) / sizeof(CasePair);
+        const CasePair* pair = std::lower_bound(LATIN_B_LOWER, end, cp, [](const CasePair& p, uint32_t value) {
+            return p.upper < value;
+        });
+        if(pair != end && pair->upper == cp) return pair->lower;
+        if(cp >= 0x1CD && cp <= 0x1DC) return cp % 2 == 1 ? cp + 1 : cp;
+        if(between(0x1DE, 0x1EF) || between(0x1F8, 0x21F) || between(0x222, 0x233)) {
+            return cp % 2 == 0 ? cp + 1 : cp;
+        }
+        return cp;
+    }
+    if(cp < 0x2B0) return cp; // IPA
+    if(cp < 0x370) {
+        // semnele diacritice combinante raman (fold le elimina), modificatorii nu
+        return cp >= 0x300 ? cp : 0;
+    }
+    if(cp < 0x400) {
+        if(cp == 0x370 || cp == 0x372 || cp == 0x376) return cp + 1;
+        if(cp == 0x371 || cp == 0x373 || cp == 0x377 || (cp >= 0x37B && cp <= 0x37D)) return cp;
+        if(cp == 0x37F) return 0x3F3;
+        if(cp == 0x386) return 0x3AC;
+        if(cp >= 0x388 && cp <= 0x38A) return cp + 0x25;
+        if(cp == 0x38C) return 0x3CC;
+        if(cp == 0x38E || cp == 0x38F) return cp + 0x3F;
+        if(cp < 0x390 || cp == 0x3A2) return 0;
+        if(cp >= 0x391 && cp <= 0x3AB) return cp + 0x20;
+        if(cp == 0x3C2) return 0x3C3; // sigma finala
+        if(cp <= 0x3CE) return cp;
+        if(cp == 0x3CF) return 0x3D7;
+        if(between(0x3D8, 0x3EF)) return cp % 2 == 0 ? cp + 1 : cp;
+        if(cp == 0x3F4) return 0x3B8;
+        if(cp == 0x3F7 || cp == 0x3FA) return cp + 1;
+        if(cp == 0x3F9) return 0x3F2;
+        if(cp >= 0x3FD) return cp - 0x82; // sigma lunara inversata / cu punct
+        return cp == 0x3F6 ? 0 : cp;
+    }
+    if(cp < 0x530) {
+        if(cp < 0x410) return cp + 0x50;
+        if(cp < 0x430) return cp + 0x20;
+        if(cp < 0x460) return cp;
+        if(cp >= 0x482 && cp <= 0x489) return 0; // semne si diacritice chirilice
+        if(cp == 0x4C0) return 0x4CF;
+        if(cp >= 0x4C1 && cp <= 0x4CE) return cp % 2 == 1 ? cp + 1 : cp;
+        if(cp == 0x4CF) return cp;
+        return cp % 2 == 0 ? cp + 1 : cp;
+    }
+    if(cp < 0x590) {
+        if(cp >= 0x531 && cp <= 0x556) return cp + 0x30;
+        return (cp >= 0x560 && cp <= 0x588) || cp == 0x559 ? cp : 0;
+    }
+    if(cp < 0x600) {
+        return (cp >= 0x5D0 && cp <= 0x5EA) || (cp >= 0x5EF && cp <= 0x5F2) ? cp : 0;
+    }
+    if(cp >= 0x1E00 && cp < 0x1F00) {
+        if(cp == 0x1E9E) return 0xDF;
+        if(cp >= 0x1E96 && cp <= 0x1E9F) return cp;
+        return cp % 2 == 0 ? cp + 1 : cp;
+    }
+    if(cp >= 0xFF00 && cp < 0x10000) {
+        if(cp >= 0xFF21 && cp <= 0xFF3A) return cp + 0x20;
+        return (cp >= 0xFF41 && cp <= 0xFF5A) || (cp >= 0xFF66 && cp <= 0xFFDC) ? cp : 0;
+    }
+    return inLetterRange(cp) ? cp : 0;
+}
+
+// litera de baza (fara diacritice) a unei litere mici, sau nullptr daca
+// litera ramane neschimbata; '?' marcheaza literele cu doua litere de baza
+const char LATIN1_BASE[] = "aaaaaa?ceeeeiiiidnooooo?ouuuuy?y"; // 0xE0..0xFF
+const char LATIN_A_BASE[] = // 0x100..0x17F
+    "aaaaaaccccccccdd" "ddeeeeeeeeeegggg" "gggghhhhiiiiiiii" "ii??jjkkklllllll"
+    "lllnnnnnnnnnoooo" "oo??rrrrrrssssss" "ssttttttuuuuuuuu" "uuuuwwyyyzzzzzzs";
+const char LATIN_B_PINYIN_BASE[] = "aaiioouuuuuuuuuu"; // 0x1CD..0x1DC
+const char LATIN_B_BASE[] = "aaaaeeeeiiiioooorrrruuuusstt"; // 0x200..0x21B
+const char VIETNAMESE_BASE[] = // 0x1EA0..0x1EF9
+    "aaaaaaaaaaaaaaaaaaaaaaaa" "eeeeeeeeeeeeeeee" "iiii"
+    "oooooooooooooooooooooooo" "uuuuuuuuuuuuuu" "yyyyyyyy";
+static_assert(sizeof(LATIN1_BASE) == 0x20 + 1 && sizeof(LATIN_A_BASE) == 0x80 + 1 &&
+              sizeof(LATIN_B_PINYIN_BASE) == 0x10 + 1 && sizeof(LATIN_B_BASE) == 0x1C + 1 &&
+              sizeof(VIETNAMESE_BASE) == 0x5A + 1, "tabele de litere de baza incomplete");
+
+inline void appendBase(uint32_t lower, std::string& out) {
+    auto single = [&out](char base) { out += base; };
+    switch(lower) {
+    case 0xAA: return single('a');
+    case 0xBA: return single('o');
+    case 0xDF: out += "ss"; return;
+    case 0xE6: out += "ae"; return;
+    case 0xFE: out += "th"; return;
+    case 0x133: out += "ij"; return;
+    case 0x153: out += "oe"; return;
+    // latina extinsa B: literele vietnameze cu corn si digrafele
+    case 0x1A1: return single('o');
+    case 0x1B0: return single('u');
+    case 0x1C6: case 0x1F3: out += "dz"; return;
+    case 0x1C9: out += "lj"; return;
+    case 0x1CC: out += "nj"; return;
+    // greaca: vocalele cu accent sau dierza
+    case 0x390: case 0x3AF: case 0x3CA: return encode(0x3B9, out);
+    case 0x3B0: case 0x3CB: case 0x3CD: return encode(0x3C5, out);
+    case 0x3AC: return encode(0x3B1, out);
+    case 0x3AD: return encode(0x3B5, out);
+    case 0x3AE: return encode(0x3B7, out);
+    case 0x3CC: return encode(0x3BF, out);
+    case 0x3CE: return encode(0x3C9, out);
+    case 0x451: return encode(0x435, out); // ё -> е
+    default: break;
+    }
+    if(lower >= 0xE0 && lower <= 0xFF) return single(LATIN1_BASE[lower - 0xE0]);
+    if(lower >= 0x100 && lower < 0x180) return single(LATIN_A_BASE[lower - 0x100]);
+    if(lower >= 0x1CD && lower <= 0x1DC) return single(LATIN_B_PINYIN_BASE[lower - 0x1CD]);
+    if(lower >= 0x200 && lower <= 0x21B) return single(LATIN_B_BASE[lower - 0x200]);
+    if(lower >= 0x1EA0 && lower <= 0x1EF9) return single(VIETNAMESE_BASE[lower - 0x1EA0]);
+    if(lower >= 0xFF41 && lower <= 0xFF5A) return single(static_cast<char>('a' + lower - 0xFF41));
+    if(lower >= 0x300 && lower < 0x370) return; // diacritice combinante
+    encode(lower, out);
+}
+
+// Rezultatul unui code point: octetii UTF-8 gata de adaugat (len = 0 daca
+// nu e litera). Cel mai lung rezultat are 3 octeti.
+struct FoldEntry {
+    uint8_t len;
+    char bytes[3];
+};
+
+// paginile tabelate din planul de baza (cp >> 8)
+const uint8_t TABLE_PAGES[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x1E, 0xFF};
+const size_t NUM_PAGES = sizeof(TABLE_PAGES);
+
+struct FoldTables {
+    int8_t page_of[256]; // pagina tabelata a fiecarui bloc de 256, sau -1
+    FoldEntry entries[2][NUM_PAGES][256]; // [0] = utf8, [1] = fold
+
+    FoldTables() {
+        std::memset(page_of, -1, sizeof(page_of));
+        std::string bytes;
+        for(size_t p = 0; p < NUM_PAGES; p++) {
+            page_of[TABLE_PAGES[p]] = static_cast<int8_t>(p);
+            for(uint32_t low = 0; low < 256; low++) {
+                uint32_t lower = lowerOf((uint32_t(TABLE_PAGES[p]) << 8) | low);
+                for(int fold = 0; fold < 2; fold++) {
+                    bytes.clear();
+                    if(lower != 0) {
+                        if(fold) appendBase(lower, bytes); else encode(lower, bytes);
+                    }
+                    FoldEntry& entry = entries[fold][p][low];
+                    entry.len = static_cast<uint8_t>(bytes.size());
+                    std::memcpy(entry.bytes, bytes.data(), bytes.size());
+                }
+            }
+        }
+    }
+};
+
+inline const FoldTables& foldTables() {
+    static const FoldTables tables;
+    return tables;
+}
+
+} // namespace utf8_detail
+
+// Normalizeaza un cuvant UTF-8 (pastreaza literele, lowercase, iar in modul
+// Fold fara diacritice); octetii invalizi se ignora. Rezultatul se scrie
+// in out, refolosit intre apeluri.
+inline void normalizeUtf8Word(std::string_view word, std::string& out, NormalizeMode mode) {
+    using namespace utf8_detail;
+    const FoldTables& tables = foldTables();
+    const int fold = mode == NormalizeMode::Fold ? 1 : 0;
+    out.clear();
+    size_t pos = 0;
+    while(pos < word.size()) {
+        unsigned char c = static_cast<unsigned char>(word[pos]);
+        if(c < 0x80) {
+            // calea ASCII, ca in normalizeWord
+            if(static_cast<unsigned char>((c | 0x20) - 'a') < 26) {
+                out += static_cast<char>(c | 0x20);
+            }
+            pos++;
+            continue;
+        }
+        uint32_t cp = 0;
+        size_t len = decode(word, pos, cp);
+        if(len == 0) {
+            pos++;
+            continue;
+        }
+        pos += len;
+        int page = cp < 0x10000 ? tables.page_of[cp >> 8] : -1;
+        if(page >= 0) {
+            const FoldEntry& entry = tables.entries[fold][page][cp & 0xFF];
+            out.append(entry.bytes, entry.len);
+        } else if(inLetterRange(cp)) {
+            out.append(word.data() + pos - len, len);
+        }
+    }
+}
+
+// true daca sirul contine octeti cu bitul de sus setat (cate 8 o data)
+inline bool hasNonAscii(std::string_view word) {
+    uint64_t bits = 0;
+    size_t i = 0;
+    for(; i + 8 <= word.size(); i += 8) {
+        uint64_t block;
+        std::memcpy(&block, word.data() + i, 8);
+        bits |= block;
+    }
+    for(; i < word.size(); i++) {
+        bits |= static_cast<unsigned char>(word[i]);
+    }
+    return (bits & 0x8080808080808080ull) != 0;
+}
+
+#endif // UTF8_NORMALIZE_H
@@ -0,0 +1,211 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+
+#include "partitioner.h"
+#include "term_dictionary.h"
+
+// Starea comuna a bucatilor unui fisier mare, impartit intre mapperi.
+// Fiecare bucata isi aduce multimea de termeni; ultima bucata terminata
+// primeste reuniunea lor si emite postarile fisierului o singura data.
+class ChunkedFile {
+private:
+    std::mutex mutex;
+    int pending; // bucatile inca neterminate
+    std::vector<std::pair<TermId, PrefixCell>> terms; // termenii adunati pana acum
+
+public:
+    explicit ChunkedFile(int num_chunks) : pending(num_chunks) {}
+
+    // adauga termenii unei bucati; intoarce true pentru ultima bucata, caz
+    // in care `part` primeste termenii distincti ai intregului fisier
+    bool addPart(std::vector<std::pair<TermId, PrefixCell>>& part) {
+        std::lock_guard<std::mutex> lock(mutex);
+        terms.insert(terms.end(), part.begin(), part.end());
+        if(--pending > 0) {
+            return false;
+        }
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+        part.swap(terms);
+        terms = {};
+        return true;
+    }
+};
+
+// Un fisier (sau o bucata dintr-un fisier mare) de procesat in faza de map
+struct MapTask {
+    std::string file_name;
+    int file_id; // pozitia (1-based) in fisierul de intrare
+    uint64_t size; // dimensiunea din stat(), 0 daca nu se cunoaste
+    uint64_t begin = 0; // intervalul nominal [begin, end) al bucatii
+    uint64_t end = 0;
+    std::shared_ptr<ChunkedFile> chunked; // nullptr pentru fisierele intregi
+};
+
+// Planificator cu work-stealing pentru mapperi.
+// Fisierele se ordoneaza descrescator dupa dimensiune si se impart intre
+// workeri (fiecare fisier ajunge la workerul cu cei mai putini octeti
+// asignati), deci fisierele mari pornesc primele. Fiecare worker are
+// propriul deque: isi ia fisierele din fata (cele mai mari), in loturi
+// de fisiere mici, iar cand ramane fara lucru fura din spatele deque-ului
+// altui worker (cele mai mici fisiere ramase).
+// Fisierele mai mari decat chunk_size se impart in bucati de chunk_size
+// octeti, tratate ca sarcini independente (granitele exacte se muta la
+// spatii de catre mapper, vezi chunkBoundary).
+class WorkStealingScheduler {
+private:
+    // un lot se opreste dupa atatea fisiere sau atatia octeti
+    static const size_t BATCH_FILES = 8;
+    static const uint64_t BATCH_BYTES = 256 * 1024;
+
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks; // indici in vectorul tasks
+        std::vector<size_t> batch; // lotul revendicat, inca neprocesat
+        size_t batch_pos = 0;
+    };
+
+    std::vector<MapTask> tasks;
+    std::unique_ptr<WorkerQueue[]> queues;
+    int num_workers = 0;
+    std::vector<int> worker_nodes; // nodul NUMA al fiecarui worker, gol = necunoscut
+    bool stealing = true;
+
+    bool sameNode(int a, int b) const {
+        return worker_nodes.empty() || worker_nodes[a] == worker_nodes[b];
+    }
+
+    // muta un lot din deque-ul dat in lotul workerului; from_front alege capatul
+    bool claimBatch(WorkerQueue& source, WorkerQueue& target, bool from_front) {
+        std::lock_guard<std::mutex> lock(source.mutex);
+        if(source.tasks.empty()) {
+            return false;
+        }
+        uint64_t bytes = 0;
+        while(!source.tasks.empty() && target.batch.size() < BATCH_FILES) {
+            size_t task = from_front ? source.tasks.front() : source.tasks.back();
+            // un fisier mare formeaza singur un lot
+            if(!target.batch.empty() && bytes + tasks[task].size > BATCH_BYTES) {
+                break;
+            }
+            if(from_front) source.tasks.pop_front(); else source.tasks.pop_back();
+            target.batch.push_back(task);
+            bytes += tasks[task].size;
+        }
+        return true;
+    }
+
+public:
+    // adauga un fisier; id-ul lui este pozitia in ordinea adaugarii (de la 1)
+    void addFile(const std::string& file_name) {
+        tasks.push_back({file_name, static_cast<int>(tasks.size()) + 1, 0});
+    }
+
+    // adauga un fisier cu un id dat explicit
+    void addFile(const std::string& file_name, int file_id) {
+        tasks.push_back({file_name, file_id, 0});
+    }
+
+    size_t size() const {
+        return tasks.size();
+    }
+
+    // nodurile NUMA ale workerilor (vezi Placement); un worker fara lucru
+    // fura intai de la cei de pe nodul lui
+    void setWorkerNodes(std::vector<int> nodes) {
+        worker_nodes = std::move(nodes);
+    }
+
+    // workerii sunt procese separate (--shuffle=process), fiecare cu copia
+    // lui a planificatorului: fiecare isi parcurge doar propriul shard
+    void disableStealing() {
+        stealing = false;
+    }
+
+    // afla dimensiunile fisierelor, imparte fisierele mari in bucati
+    // (chunk_size = 0 dezactiveaza impartirea) si le distribuie workerilor
+    void distribute(int workers, uint64_t chunk_size) {
+        num_workers = workers;
+        queues.reset(new WorkerQueue[workers]);
+
+        std::vector<MapTask> files;
+        files.swap(tasks);
+        for(auto& file : files) {
+            struct stat st;
+            file.size = stat(file.file_name.c_str(), &st) == 0 ? st.st_size : 0;
+            // un fisier comprimat se decomprima doar de la inceput
+            if(chunk_size == 0 || file.size <= chunk_size
+               || detectFileCompression(file.file_name) != Compression::None) {
+                tasks.push_back(std::move(file));
+                continue;
+            }
+            int num_chunks = static_cast<int>((file.size + chunk_size - 1) / chunk_size);
+            auto chunked = std::make_shared<ChunkedFile>(num_chunks);
+            for(int c = 0; c < num_chunks; c++) {
+                MapTask chunk = file;
+                chunk.begin = c * chunk_size;
+                chunk.end = std::min(file.size, chunk.begin + chunk_size);
+                chunk.size = chunk.end - chunk.begin;
+                chunk.chunked = chunked;
+                tasks.push_back(std::move(chunk));
+            }
+        }
+
+        std::vector<size_t> order(tasks.size());
+        for(size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return tasks[a].size > tasks[b].size;
+        });
+
+        // (octeti asignati, worker) - fiecare fisier merge la cel mai liber worker
+        using Load = std::pair<uint64_t, int>;
+        std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+        for(int w = 0; w < workers; w++) loads.push({0, w});
+        for(size_t task : order) {
+            Load load = loads.top();
+            loads.pop();
+            queues[load.second].tasks.push_back(task);
+            load.first += std::max<uint64_t>(tasks[task].size, 1);
+            loads.push(load);
+        }
+    }
+
+    // urmatorul fisier pentru workerul dat; false cand nu mai e nimic de facut
+    bool next(int worker, MapTask& task) {
+        WorkerQueue& own = queues[worker];
+        if(own.batch_pos == own.batch.size()) {
+            own.batch.clear();
+            own.batch_pos = 0;
+            bool claimed = claimBatch(own, own, true);
+            // deque-ul propriu e gol: se fura de la ceilalti workeri, intai
+            // de la cei de pe acelasi nod
+            for(int pass = 0; stealing && !claimed && pass < 2; pass++) {
+                for(int i = 1; !claimed && i < num_workers; i++) {
+                    int victim = (worker + i) % num_workers;
+                    if(sameNode(worker, victim) == (pass == 0)) {
+                        claimed = claimBatch(queues[victim], own, false);
+                    }
+                }
+            }
+            if(!claimed) {
+                return false;
+            }
+        }
+        task = tasks[own.batch[own.batch_pos++]];
+        return true;
+    }
+};
+
+#endif // WORK_STEALING_H